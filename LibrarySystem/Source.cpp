@@ -1,891 +1,4549 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <map>
+#include <unordered_set>
+#include <memory>
+#include <new>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <chrono>
-
-bool alphabetical(std::string a, std::string b);
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+bool alphabetical(const std::string& a, const std::string& b);
+size_t stringHeapBytes(const std::string& str);
 void initializeLibraries(void);
+void loadCheckedOutFile(std::string& warnings);
+void loadBranchFile(int branch, std::string& warnings);
+void loadBranchRegistry(void);
+void exportCsvFiles(void);
+std::string binarySnapshotFilename(const std::string& csvFilename);
+void parseCsvFile(const std::string& contents, int fieldsPerRecord, std::vector<std::string>& fields, long long& checkpoint);
+void parseCsvChunk(const char* data, size_t length, int fieldsPerRecord, std::vector<std::string>& fields, long long& checkpoint);
+bool readChangedCsvFile(const std::string& csvFilename, const std::string& binaryContents, int fieldsPerRecord, std::vector<std::string>& fields, long long& sequence, bool& keptFlag, std::string& warnings);
 void cmdWindowControl(void);
-void writebackAndReinitialize(void);
-
-static std::mutex s_mu;
-static bool s_endProgram = false;
-static bool s_spreadsheetWritebackFlag = false;
-static bool s_CentralBranchBooksShelvedFlag = false;
-static bool s_PGBranchBooksShelvedFlag = false;
-static bool s_MPBranchBooksShelvedFlag = false;
+void writebackChanges(void);
+bool persistChanges(void);
+void lockForSnapshot(void);
+void unlockForSnapshot(void);
+bool writeSnapshotFile(const std::string& filename, const std::string& contents, bool checksumFlag = true);
+bool readSnapshotFile(const std::string& filename, std::string& contents, bool* changedFlag = NULL);
+unsigned long long snapshotChecksum(const char* data, size_t length);
+bool replaceFile(const std::string& from, const std::string& to);
+void appendCsvField(std::string& buffer, const std::string& field);
+void appendBinaryString(std::string& records, std::string& pool, const std::string& str, std::unordered_map<std::string, uint32_t>* pooled);
+bool readBinaryString(const std::string& contents, size_t& position, size_t poolStart, std::string* str);
+bool syncFile(FILE* file);
+bool parseInteger(const std::string& text, long long& value);
+bool replayWriteAheadLog(void);
+int checkOutBook(const std::string& title, const std::string& author, const std::string& patron, long long& sequence);
+long long returnBook(const std::string& title, const std::string& author, int branch);
+void printBranchMatches(const std::string& prefix, const std::string& select);
+
+//Each Library and the checked out books (the loan table) have their own shared mutex. The catalogues
+//are read under a shared lock and changed under an exclusive lock. To avoid deadlocks the locks are
+//always taken in the same order: the branches in order of branchId, then the loan table. The availability
+//index and the write ahead log have their own mutexes, which are only held briefly inside those locks.
+static std::atomic<bool> s_endProgram(false);
+static std::atomic<bool> s_spreadsheetWritebackFlag(false);
+
+//Files larger than this are split into chunks of about this size which are parsed in parallel.
+static const size_t s_parseChunkBytes = 1 << 20;
+
+//Lists of nodes longer than this are sorted in parallel, in chunks of at least this many nodes.
+static const size_t s_sortChunkNodes = 1 << 16;
+
+//Returned books are shelved once this many have been returned to a branch, or once the first
+//of them has waited this many seconds on the cart, whichever comes first. Both can be set in the
+//branch registry file, and are only changed while it is read, before the branch workers start.
+static int s_shelvingBatchSize = 5;
+static int s_shelvingBatchSeconds = 60;
+
+//The most books a prefix search lists, so typing a short prefix still answers quickly.
+static const int s_searchResultLimit = 10;
+
+//When set, writeback saves each library and the checked out books as a binary snapshot (.bin) which
+//is loaded at startup instead of the .csv file. The .csv files are still read if there is no binary
+//snapshot, and are brought up to date when the program exits, so they can be used to import and export.
+static const bool s_binarySnapshotFlag = true;
+
+//Set on an entry of a sorted order array in a binary snapshot when the book is a copy of the book before it.
+static const uint32_t s_copyOfPreviousBit = 0x80000000;
+
+//The length of the "#checksum,<16 hex digits>" line at the end of every file written by writeSnapshotFile.
+static const size_t s_checksumLineLength = 27;
 
 /*
-	class description:
-	Objects of bookNode are used as storage for the title and author of a book, and as
-	nodes that are part of two different binary search trees. The left leaf always comes
-	alphabetically before the right leaf. There is a binary search tree for both the title
-	and the author, which is the reason for the 4 bookNode pointers defined.
+Appends a value to a binary snapshot, in the byte order of this machine.
 */
-class bookNode
+template <typename T>
+void appendBinaryValue(std::string& buffer, T value)
 {
-private:
-	std::string title;
-	std::string authorName;
-	bool deleteFlag = false;
-public:
-
-	bookNode* rightLeafTitle = NULL;
-	bookNode* leftLeafTitle = NULL;
-	bookNode* rightLeafAuthor = NULL;
-	bookNode* leftLeafAuthor = NULL;
+	buffer.append((const char*)&value, sizeof(T));
+}
 
-	void assign(std::string Title, std::string Author)
-	{
-		title = Title;
-		authorName = Author;
-	}
-	std::string getTitle(void)
-	{
-		return title;
-	}
-	std::string getAuthorName(void)
-	{
-		return authorName;
-	}
+/*
+Reads a value from a binary snapshot and moves the position past it.
+*/
+template <typename T>
+T readBinaryValue(const std::string& contents, size_t& position)
+{
+	T value;
 
-	/*
-		function description:
-		The delete flag is here because when a book is removed from the binary search tree,
-		it isn't deleted from memory or removed from the tree (this would cause issues with
-		the overlapping trees). Instead, the delete flag is set to true, and the 'removed'
-		bookNode isn't written back into the .csv file that is used to create this tree.
-	*/
-	void setDeleteFlag(void)
-	{
-		deleteFlag = true;
-	}
-	bool getDeleteFlag(void)
-	{
-		return deleteFlag;
-	}
-};
+	memcpy(&value, contents.data() + position, sizeof(T));
+	position += sizeof(T);
+	return value;
+}
 
 /*
 	class description:
-	the bookTree class is a binary search tree that contains all the functions which
-	allocate, traverse, access data from, and deallocate bookNodes.
-
-	the bookTree class also does all of the writing back to the spreadsheet .csv files.
+	The stringPool keeps one copy of every title, author, and patron name, and hands out a 32 bit handle
+	for each one. A string used many times (an author with many books, a book with many copies, a patron
+	with many loans) is only stored once, and the nodes and indexes store handles rather than strings.
+
+	important info:
+	 - The same string always gets the same handle, so two strings can be checked for equality by
+	 comparing their handles.
+	 - Each string has a collation key, its first 8 bytes packed into an integer so that comparing two
+	 keys gives the same order as comparing the start of the strings. Most comparisons are decided by
+	 the keys, without reading the strings.
+	 - The strings are split into shards by hash, each with its own lock, so the files loaded on separate
+	 threads at startup can intern strings at the same time. Strings are never moved or removed once they
+	 are added, so reading a string by its handle doesn't need a lock.
+	 - The shard is picked from the high bits of the hash, since the set of handles in each shard uses
+	 the low bits of the same hash for its buckets.
+	 - The entries of a shard are allocated in chunks that double in size, so a small library doesn't
+	 allocate thousands of entries in every shard. The chunk of an entry is found from the highest bit
+	 of its index, which is also why the chunks don't stop doubling like the chunks of nodeSlab do.
 */
-class bookTree
+class stringPool
 {
 private:
+	static const int SHARD_BITS = 4;
+	static const int SHARD_COUNT = 1 << SHARD_BITS;
+	static const int FIRST_CHUNK_BITS = 6;
+	static const uint32_t FIRST_CHUNK_SIZE = 1 << FIRST_CHUNK_BITS;
+	static const int CHUNK_COUNT = 32 - SHARD_BITS - FIRST_CHUNK_BITS + 1;
 
-	/*
-		function description:
-		Prints the binary search tree in post order to the .csv file, this is done during writeback.
-		It is done in post order, because, if the .csv file were to become in alphabetical order then the tree
-		would become a linked list, which has a slower search time then a binary search tree.
-
-		PARAM:	bookNode* node, used to traverse the tree recursively.
-		PARAM:	ofstream file, file stream of the .csv file.
-		PARAM:	integer num, a random number (0 or 1) which decides whether to writeback with the
-				title tree or the author tree. The goal of this is to keep the .csv file as randomized
-				as possible to optimize the binary search tree.
-	*/
-	void printPostOrderToFile(bookNode* node, std::ofstream& file, int num)
+	struct poolEntry
 	{
-		std::string line;
-		std::string title;
-		std::string author;
-
-		//base case
-		if (node == NULL)
-			return;
+		std::string text;
+		unsigned long long collationKey;
+	};
 
-		if (num == 1)
+	//The set of handles in a shard hashes and compares the strings the handles refer to.
+	struct handleHash
+	{
+		stringPool* pool;
+		size_t operator()(uint32_t handle) const
 		{
-			printPostOrderToFile(node->leftLeafTitle, file, num);
-			printPostOrderToFile(node->rightLeafTitle, file, num);
+			return std::hash<std::string>()(pool->get(handle));
 		}
-		else
+	};
+	struct handleEqual
+	{
+		stringPool* pool;
+		bool operator()(uint32_t a, uint32_t b) const
 		{
-			printPostOrderToFile(node->leftLeafAuthor, file, num);
-			printPostOrderToFile(node->rightLeafAuthor, file, num);
+			return pool->get(a) == pool->get(b);
 		}
+	};
+
+	struct poolShard
+	{
+		std::mutex shardMutex;
+		std::unique_ptr<poolEntry[]> chunks[CHUNK_COUNT];
+		uint32_t size = 0;
+		std::unordered_set<uint32_t, handleHash, handleEqual> handles;
 
-		//only write back if the delete flag is false
-		if (!node->getDeleteFlag())
+		poolShard(stringPool* pool) : handles(0, handleHash{ pool }, handleEqual{ pool })
 		{
-			line = node->getTitle() + ',' + node->getAuthorName() + '\n';
-			file << line;
 		}
-	}
+	};
+
+	std::unique_ptr<poolShard> shards[SHARD_COUNT];
 
 	/*
 		function description:
-		Deallocates the binary search tree.
-
-		PARAM: bookNode* node, used to traverse the binary search tree recursively.
+		Returns the shard a string belongs in, from the high bits of its hash.
 	*/
-	void postOrderDeallocation(bookNode* node)
+	static int shardOf(const std::string& str)
 	{
-		//base case
-		if (node == NULL)
-			return;
-
-		postOrderDeallocation(node->leftLeafTitle);
-		postOrderDeallocation(node->rightLeafTitle);
-		delete node;
+		return (int)(std::hash<std::string>()(str) >> ((sizeof(size_t) * 8) - SHARD_BITS));
 	}
 
-protected:
-	bookNode* root;
-
 	/*
 		function description:
-		Prints the books in alphabetical order (title or author).
+		Finds where the entry at an index of a shard is. Chunk n holds FIRST_CHUNK_SIZE << n entries,
+		so the chunk is found from the highest bit of the index plus FIRST_CHUNK_SIZE.
 
-		PARAM: bookNode* node, used to traverse the tree recursively.
-		PARAM: string select, selection for title or author.
+		PARAM: uint32_t index, the index of the entry in its shard.
+		PARAM: int chunk, set to the chunk the entry is in.
+		RETURN: uint32_t, the position of the entry in its chunk.
 	*/
-	void printInOrder(bookNode* node, std::string select)
+	static uint32_t locate(uint32_t index, int& chunk)
 	{
-		std::string title;
-		std::string authorName;
-		std::string space;
-		int spaceLength;
-		int titleLength;
-
-		//base case
-		if (node == NULL)
-			return;
+		uint32_t position = index + FIRST_CHUNK_SIZE;
+		int highestBit;
+
+#ifdef _MSC_VER
+		unsigned long bit;
+		_BitScanReverse(&bit, position);
+		highestBit = (int)bit;
+#else
+		highestBit = 31 - __builtin_clz(position);
+#endif
+		chunk = highestBit - FIRST_CHUNK_BITS;
+		return position - (1u << highestBit);
+	}
 
-		//creating string variable 'space' to format the output.
-		title = node->getTitle();
-		authorName = node->getAuthorName();
-		space = "";
-		titleLength = title.length();
-		spaceLength = space.length();
+	poolEntry& entry(uint32_t handle)
+	{
+		int chunk;
+		uint32_t position = locate(handle >> SHARD_BITS, chunk);
 
-		while (spaceLength + titleLength < 50)
-		{
-			space = space + " ";
-			spaceLength = space.length();
-		}
+		return shards[handle & (SHARD_COUNT - 1)]->chunks[chunk][position];
+	}
 
-		//In order printing algorithm. 
-		//Recurses along title leafs if title is selected,
-		//and along author leafs if author is selected.
-		if (select == "title")
-		{
-			printInOrder(node->leftLeafTitle, select);
+	/*
+		function description:
+		Copies a string into the next free entry of a shard, without adding it to the shard yet, so the
+		set of handles can be searched for it. The shard must be locked.
 
-			if (!node->getDeleteFlag())
-			{
-				std::cout << title << space << " by      " << authorName << std::endl;
-			}
+		RETURN: uint32_t, the handle the string would have if it were added.
+	*/
+	uint32_t stageString(poolShard& shard, int shardNumber, const std::string& str)
+	{
+		uint32_t index = shard.size;
+		int chunk;
+		uint32_t position = locate(index, chunk);
+
+		if (!shard.chunks[chunk])
+			shard.chunks[chunk].reset(new poolEntry[FIRST_CHUNK_SIZE << chunk]);
+		shard.chunks[chunk][position].text = str;
+		return (index << SHARD_BITS) | shardNumber;
+	}
 
-			printInOrder(node->rightLeafTitle, select);
-		}
-		else if (select == "author")
-		{
-			printInOrder(node->leftLeafAuthor, select);
+public:
+	stringPool()
+	{
+		for (int i = 0; i < SHARD_COUNT; i++)
+			shards[i].reset(new poolShard(this));
+	}
 
-			if (!node->getDeleteFlag())
-			{
-				std::cout << title << space << " by      " << authorName << std::endl;
-			}
+	/*
+		function description:
+		Returns the handle of a string, adding the string to the pool if it isn't already in it.
+	*/
+	uint32_t intern(const std::string& str)
+	{
+		int shardNumber = shardOf(str);
+		poolShard& shard = *shards[shardNumber];
+		std::lock_guard<std::mutex> lock(shard.shardMutex);
+		std::unordered_set<uint32_t, handleHash, handleEqual>::iterator match;
+		uint32_t handle;
+		unsigned long long key = 0;
+
+		handle = stageString(shard, shardNumber, str);
+		match = shard.handles.find(handle);
+		if (match != shard.handles.end())
+			return *match;
+
+		for (int i = 0; i < 8; i++)
+			key = (key << 8) | ((i < (int)str.length()) ? (unsigned char)str[i] : 0);
+		entry(handle).collationKey = key;
+		shard.handles.insert(handle);
+		shard.size++;
+		return handle;
+	}
 
-			printInOrder(node->rightLeafAuthor, select);
-		}
-		else
-			std::cout << "incorrect selection, must be 'title' or 'author'";
+	/*
+		function description:
+		Finds the handle of a string without adding it to the pool.
 
+		RETURN: bool, false if the string isn't in the pool, in which case no book or patron uses it.
+	*/
+	bool find(const std::string& str, uint32_t& handle)
+	{
+		int shardNumber = shardOf(str);
+		poolShard& shard = *shards[shardNumber];
+		std::lock_guard<std::mutex> lock(shard.shardMutex);
+		std::unordered_set<uint32_t, handleHash, handleEqual>::iterator match;
+
+		match = shard.handles.find(stageString(shard, shardNumber, str));
+		if (match == shard.handles.end())
+			return false;
+		handle = *match;
+		return true;
 	}
 
-public:
-	bookTree()
+	const std::string& get(uint32_t handle)
 	{
-		root = NULL;
+		return entry(handle).text;
 	}
 
 	/*
 		function description:
-		Prints the books in bookTree in either alphabetical order based off of the book title, or the authors name.
+		Compares the strings of two handles alphabetically, using the collation keys first.
 
-		PARAM: string select: the selection for which alphabetical order (must be 'title' or 'author')
+		RETURN: int, less than, equal to, or greater than zero, the same as std::string::compare.
 	*/
-	void printList(std::string select)
+	int compare(uint32_t a, uint32_t b)
 	{
-		printInOrder(root, select);
+		unsigned long long keyA, keyB;
+
+		if (a == b)
+			return 0;
+		keyA = entry(a).collationKey;
+		keyB = entry(b).collationKey;
+		if (keyA != keyB)
+			return (keyA < keyB) ? -1 : 1;
+		return entry(a).text.compare(entry(b).text);
 	}
 
-	void addBook(std::string title, std::string author)
+	/*
+		function description:
+		Returns the number of bytes the pool has allocated on the heap, with the sets of handles
+		estimated as one node per string plus the buckets.
+	*/
+	size_t memoryUsage(void)
 	{
-		bookNode* newnode;
-		bookNode* traversal;
-		bookNode* previous;
-
-		newnode = new bookNode;
-		newnode->assign(title, author);
+		size_t bytes = 0;
 
-		//If the binary search tree is empty, set the newnode as the root.
-		if (root == NULL)
+		for (int i = 0; i < SHARD_COUNT; i++)
 		{
-			root = newnode;
-			return;
+			std::lock_guard<std::mutex> lock(shards[i]->shardMutex);
+
+			bytes += sizeof(poolShard);
+			for (int j = 0; (j < CHUNK_COUNT) && shards[i]->chunks[j]; j++)
+				bytes += (FIRST_CHUNK_SIZE << j) * sizeof(poolEntry);
+			for (uint32_t j = 0; j < shards[i]->size; j++)
+				bytes += stringHeapBytes(entry((j << SHARD_BITS) | i).text);
+			bytes += (shards[i]->handles.bucket_count() * sizeof(void*)) + (shards[i]->size * (sizeof(uint32_t) + (2 * sizeof(void*))));
 		}
+		return bytes;
+	}
+};
 
-		traversal = root;
-		previous = NULL;
-
-		//Traverses through the title tree and places the new book in alphabetical order.
-		while (traversal != NULL)
-		{
-			if (alphabetical(newnode->getTitle(), traversal->getTitle()))
-			{
-				previous = traversal;
-				traversal = traversal->leftLeafTitle;
-			}
-			else
-			{
-				previous = traversal;
-				traversal = traversal->rightLeafTitle;
-			}
-		}
-		if (alphabetical(newnode->getTitle(), previous->getTitle()))
-			previous->leftLeafTitle = newnode;
-		else
-			previous->rightLeafTitle = newnode;
+static stringPool s_stringPoolObject;
 
-		//Traverses through the author tree and places the new book in alphabetical order.
-		traversal = root;
-		previous = NULL;
+/*
+	The key of the exact match index in bookTree, and of the other indexes that look a book up by
+	its title and author. A book is only matched if both the title and the author are the same.
+*/
+struct bookKey
+{
+	uint32_t title;
+	uint32_t authorName;
 
-		while (traversal != NULL)
-		{
-			if (alphabetical(newnode->getAuthorName(), traversal->getAuthorName()))
-			{
-				previous = traversal;
-				traversal = traversal->leftLeafAuthor;
-			}
-			else
-			{
-				previous = traversal;
-				traversal = traversal->rightLeafAuthor;
-			}
-		}
-		if (alphabetical(newnode->getAuthorName(), previous->getAuthorName()))
-			previous->leftLeafAuthor = newnode;
-		else
-			previous->rightLeafAuthor = newnode;
+	bool operator==(const bookKey& other) const
+	{
+		return (title == other.title) && (authorName == other.authorName);
 	}
 
 	/*
 		function description:
-		Effectively deletes a book from the binary search tree (sets the delete flag as true).
-
-		PARAM: string title, the title of the book being deleted.
-		PARAM: string author, the author of the book being deleted.
-		RETURN: bool, an indicator of whether a book with the given parameters
-		was actually deleted (if no book matches the parameters, false is returned)
+		Makes the key of a book from its title and author, adding them to the string pool.
 	*/
-	bool deleteBook(std::string title, std::string author)
+	static bookKey intern(const std::string& title, const std::string& author)
 	{
-		bookNode* traversal;
-		std::string traversalTitle;
-		std::string traversalAuthor;
-
-		traversal = root;
-		traversalTitle = traversal->getTitle();
-		traversalAuthor = traversal->getAuthorName();
-
-		//Traverses the title tree and stops iterating if a book is found which matches the paramters,
-		//returns false if the book is absent from the binary search tree
-		while ((title != traversalTitle) && (author != traversalAuthor))
-		{
-
-			if (alphabetical(title, traversalTitle))
-			{
-				if (traversal->leftLeafTitle == NULL)
-					return false;
-				traversal = traversal->leftLeafTitle;
-			}
-			else
-			{
-				if (traversal->rightLeafTitle == NULL)
-					return false;
-				traversal = traversal->rightLeafTitle;
-			}
-
-
-			traversalTitle = traversal->getTitle();
-			traversalAuthor = traversal->getAuthorName();
-		}
-
-		//Effective deletion of the book. Actual removal from memory comes 
-		//when the book is deallocated but isn't written back into the .csv file.  
-		traversal->setDeleteFlag();
-		return true;
+		return bookKey{ s_stringPoolObject.intern(title), s_stringPoolObject.intern(author) };
 	}
 
 	/*
 		function description:
-		Writes the books in the binary search tree back into the .csv file.
+		Makes the key of a book from its title and author, without adding them to the string pool.
 
-		PARAM:string filename, the filename to be written back into.
+		RETURN: bool, false if the title or author isn't in the pool, in which case there is no such book.
 	*/
-	void writeback(std::string filename)
+	static bool find(const std::string& title, const std::string& author, bookKey& key)
 	{
-		bookNode* node;
-		std::ofstream file;
+		return s_stringPoolObject.find(title, key.title) && s_stringPoolObject.find(author, key.authorName);
+	}
+};
+
+struct bookKeyHash
+{
+	size_t operator()(const bookKey& key) const
+	{
+		return std::hash<unsigned long long>()(((unsigned long long)key.title << 32) | key.authorName);
+	}
+};
 
-		//Integer num is used to decide whether writeback is done in post order with title 
-		//tree or author tree, which increases the randomization of the .csv file.
-		int num = rand() % 2;
-		file.open(filename);
-		file.close();
-		file.open(filename, std::ios::app);
+/*
+	Orders bookKeys by title, then by author, in the same order as the title tree. A key can also be compared
+	with a string, which is compared with the title only, so an ordered index of bookKeys can be searched for
+	the first title at or after a prefix without adding the prefix to the string pool.
+*/
+struct bookKeyTitleLess
+{
+	typedef void is_transparent;
 
-		node = root;
+	bool operator()(const bookKey& a, const bookKey& b) const
+	{
+		int comparison = s_stringPoolObject.compare(a.title, b.title);
 
-		//Call to printPostOrderToFile does the actual writing to the file.
-		printPostOrderToFile(node, file, num);
-		file.close();
+		if (comparison != 0)
+			return comparison < 0;
+		return s_stringPoolObject.compare(a.authorName, b.authorName) < 0;
 	}
-
-	/*
-			funciton definition:
-			deallocates the book tree by calling the recursive deallocation function.
-	*/
-	~bookTree()
+	bool operator()(const bookKey& a, const std::string& b) const
 	{
-		bookNode* node;
-		node = root;
-		postOrderDeallocation(node);
-		root = NULL;
+		return s_stringPoolObject.get(a.title) < b;
+	}
+	bool operator()(const std::string& a, const bookKey& b) const
+	{
+		return a < s_stringPoolObject.get(b.title);
 	}
 };
 
+/*
+	Selects which of the two binary search trees a bookNode function is working on.
+*/
+enum treeSelect
+{
+	TITLE_TREE,
+	AUTHOR_TREE
+};
+
 /*
 	class description:
-	Inherits from the bookTree class, also keeps track of a patron name in addition to
-	the title and author parameters. The patron name is also included in the .csv file.
+	Objects of bookNode are used as storage for the title and author of a book, and as
+	nodes that are part of two different binary search trees. The left leaf always comes
+	alphabetically before the right leaf. There is a binary search tree for both the title
+	and the author, which is the reason for the 4 bookNode pointers defined.
+
+	Both trees are AVL trees, so each node also keeps its height in each tree, and the number of
+	nodes in its subtree of each tree, so the k-th book and the rank of a book are found in O(log n).
+	The title and author are kept in the string pool, the node only has their handles.
 */
-class patronNode : public bookTree
+class bookNode
 {
 private:
-	std::string name;
-
-	/*
-		function description:
-		Exactly the same function as the writeback for just a book tree,
-		except it prints the patron name in addition to the title and author.
-	*/
-	void patronPrintPostOrderToFile(bookNode* node, std::ofstream& file, int num)
-	{
-		std::string line;
-		std::string title;
-		std::string author;
+	uint32_t title;
+	uint32_t authorName;
+public:
 
-		if (node == NULL)
-			return;
+	bookNode* rightLeafTitle = NULL;
+	bookNode* leftLeafTitle = NULL;
+	bookNode* rightLeafAuthor = NULL;
+	bookNode* leftLeafAuthor = NULL;
+	int heightTitle = 1;
+	int heightAuthor = 1;
+	int sizeTitle = 1;
+	int sizeAuthor = 1;
 
-		if (num == 1)
-		{
-			patronPrintPostOrderToFile(node->leftLeafTitle, file, num);
-			patronPrintPostOrderToFile(node->rightLeafTitle, file, num);
-		}
-		else
-		{
-			patronPrintPostOrderToFile(node->leftLeafAuthor, file, num);
-			patronPrintPostOrderToFile(node->rightLeafAuthor, file, num);
-		}
-		if (!node->getDeleteFlag())
-		{
-			line = node->getTitle() + ',' + node->getAuthorName() + ',' + name + '\n';
-			file << line;
-		}
+	void assign(const std::string& Title, const std::string& Author)
+	{
+		title = s_stringPoolObject.intern(Title);
+		authorName = s_stringPoolObject.intern(Author);
 	}
-public:
-	patronNode* next = NULL;
-
-	void setName(std::string Name)
+	const std::string& getTitle(void)
 	{
-		name = Name;
+		return s_stringPoolObject.get(title);
 	}
-	std::string getName(void)
+	const std::string& getAuthorName(void)
 	{
-		return name;
+		return s_stringPoolObject.get(authorName);
+	}
+	bookKey getBookKey(void)
+	{
+		return bookKey{ title, authorName };
 	}
 
 	/*
-		Similar function as used for just the book tree class, except the file open
-		and closing is already done in the other function.
+		Accessors for the leafs, height, size, and key of either tree,
+		so that the balancing code in bookTree is written once for both trees.
 	*/
-	void patronWriteback(std::string filename, std::ofstream& file)
+	bookNode*& leftLeaf(treeSelect tree)
 	{
-		bookNode* node;
-		int num = rand() % 2;
-
-		node = root;
-
-		patronPrintPostOrderToFile(node, file, num);
+		return (tree == TITLE_TREE) ? leftLeafTitle : leftLeafAuthor;
+	}
+	bookNode*& rightLeaf(treeSelect tree)
+	{
+		return (tree == TITLE_TREE) ? rightLeafTitle : rightLeafAuthor;
+	}
+	int& height(treeSelect tree)
+	{
+		return (tree == TITLE_TREE) ? heightTitle : heightAuthor;
+	}
+	int& size(treeSelect tree)
+	{
+		return (tree == TITLE_TREE) ? sizeTitle : sizeAuthor;
+	}
+	const std::string& getKey(treeSelect tree)
+	{
+		return s_stringPoolObject.get((tree == TITLE_TREE) ? title : authorName);
+	}
+	uint32_t getKeyHandle(treeSelect tree)
+	{
+		return (tree == TITLE_TREE) ? title : authorName;
 	}
+};
 
+/*
+	One book found by a prefix search, with the number of copies of it, so that a book with many
+	copies is only listed once.
+*/
+struct prefixMatch
+{
+	std::string title;
+	std::string author;
+	int copies;
 };
 
 /*
 	class description:
-	the patronList class does all operations that allocate, traverse, access data from, and deallocate
-	from a linked list of patronNodes.
+	The catalogueWriter formats the lines of a catalogue into a buffer that is reused from one line to the next,
+	and only writes the buffer to std::cout once it is full, so printing a large catalogue makes few system calls
+	and doesn't allocate any memory for each line. Whatever is left in the buffer is written when the writer is
+	destroyed.
 */
-class patronList
+class catalogueWriter
 {
 private:
-	patronNode* head;
-	std::string writebackFilename;
+	static const size_t BUFFER_SIZE = 1 << 16;
+	static const size_t TITLE_WIDTH = 50;
+
+	std::string buffer;
 
 public:
-	patronList(std::string WritebackFilename)
+	catalogueWriter()
 	{
-		writebackFilename = WritebackFilename;
-		head = NULL;
+		buffer.reserve(BUFFER_SIZE);
 	}
+	catalogueWriter(const catalogueWriter&) = delete;
+	catalogueWriter& operator=(const catalogueWriter&) = delete;
 
 	/*
 		function description:
-		Prints the checked out books by traversing the linked list and printing the patron (book tree) in each node.
-
-		PARAM: string select, selects whether to print alphabetically according to title or author.
+		Appends the line for one book to a buffer, with the title padded to a fixed width so the authors line up.
 	*/
-	void printList(std::string select)
+	static void appendBook(std::string& buffer, const char* title, size_t titleLength, const char* author, size_t authorLength)
 	{
-		patronNode* traversal;
-		traversal = head;
-
-		//Prints head node.
-		std::cout << traversal->getName() << " has the following books checked out:" << std::endl;
-		traversal->printList(select);
-		std::cout << std::endl;
+		buffer.append(title, titleLength);
+		if (titleLength < TITLE_WIDTH)
+			buffer.append(TITLE_WIDTH - titleLength, ' ');
+		buffer.append(" by      ");
+		buffer.append(author, authorLength);
+		buffer += '\n';
+	}
 
-		if (traversal->next == NULL)
-			return;
+	void writeBook(const char* title, size_t titleLength, const char* author, size_t authorLength)
+	{
+		appendBook(buffer, title, titleLength, author, authorLength);
+		if (buffer.length() >= BUFFER_SIZE)
+			flush();
+	}
 
-		//Prints the remaining nodes.
-		do
-		{
-			traversal = traversal->next;
-			std::cout << traversal->getName() << " has the following books checked out:" << std::endl;
-			traversal->printList(select);
-			std::cout << std::endl;
-		} while (traversal->next != NULL);
+	void writeLine(const std::string& line)
+	{
+		buffer += line;
+		buffer += '\n';
+		if (buffer.length() >= BUFFER_SIZE)
+			flush();
 	}
 
+	void flush(void)
+	{
+		std::cout.write(buffer.data(), buffer.length());
+		std::cout.flush();
+		buffer.clear();
+	}
+
+	~catalogueWriter()
+	{
+		flush();
+	}
+};
+
+/*
+	class description:
+	A catalogueOrder is a sorted array copy of either the title tree or the author tree of a bookTree,
+	used to print the catalogue. Walking the tree jumps between nodes all over the heap, whereas the
+	catalogueOrder keeps the books in order in contiguous memory, so a scan through the catalogue reads
+	memory front to back.
+
+	important info:
+	 - The titles and authors are stored back to back in one string, and each entry only keeps offsets
+	 into that string.
+	 - Every CATALOGUE_BLOCK_SIZE-th key is copied into a small sparse index. A search does a binary search
+	 on the sparse index to find the right block, then scans at most one block of entries.
+*/
+class catalogueOrder
+{
+private:
+	static const int CATALOGUE_BLOCK_SIZE = 32;
+
+	struct catalogueEntry
+	{
+		unsigned int titleOffset;
+		unsigned int titleLength;
+		unsigned int authorOffset;
+		unsigned int authorLength;
+	};
+
+	treeSelect tree = TITLE_TREE;
+	std::string text;
+	std::vector<catalogueEntry> entries;
+	std::vector<std::string> sparseIndex;
+
+	int compareKey(int index, const std::string& key) const
+	{
+		if (tree == TITLE_TREE)
+			return text.compare(entries[index].titleOffset, entries[index].titleLength, key);
+		return text.compare(entries[index].authorOffset, entries[index].authorLength, key);
+	}
+
+public:
 	/*
 		function description:
-		Checks out a book (adds to the patron list) by traversing through the linked list to see whether the patron who is
-		checking a book out is already in the system. If they are in the system, the book is added to their binary search tree.
-		If they are not in the system, a patron node is allocated and assigned the parameters.
+		Rebuilds the array from a tree with an iterative in order traversal.
 
-		PARAM: string title, title of the book being checked out.
-		PARAM: string author, author of the book being checked out.
-		PARAM: patronName, name of the patron checking the book out.
+		PARAM: bookNode* root, the root of the tree being copied.
+		PARAM: treeSelect Tree, whether the title tree or the author tree is being copied.
 	*/
-	void checkOut(std::string title, std::string author, std::string patronName)
+	void build(bookNode* root, treeSelect Tree)
 	{
-		patronNode* patron;
-		patronNode* newnode;
+		std::vector<bookNode*> stack;
+		bookNode* node = root;
+		catalogueEntry entry;
 
-		//If linked list is empty, add a new node to the head.
-		if (head == NULL)
+		tree = Tree;
+		text.clear();
+		entries.clear();
+		sparseIndex.clear();
+
+		while ((node != NULL) || !stack.empty())
 		{
-			newnode = new patronNode;
-			newnode->setName(patronName);
-			newnode->addBook(title, author);
-			head = newnode;
-			return;
+			while (node != NULL)
+			{
+				stack.push_back(node);
+				node = node->leftLeaf(tree);
+			}
+			node = stack.back();
+			stack.pop_back();
+
+			if (entries.size() % CATALOGUE_BLOCK_SIZE == 0)
+				sparseIndex.push_back(node->getKey(tree));
+
+			entry.titleOffset = text.length();
+			entry.titleLength = node->getTitle().length();
+			text += node->getTitle();
+			entry.authorOffset = text.length();
+			entry.authorLength = node->getAuthorName().length();
+			text += node->getAuthorName();
+			entries.push_back(entry);
+
+			node = node->rightLeaf(tree);
 		}
+	}
+
+	/*
+		function description:
+		Finds the first book whose key (title or author) does not come before the key parameter.
+
+		PARAM: string key, the title or author being searched for.
+		RETURN: integer, the index of the first book at or after the key, or the size if there is none.
+	*/
+	int lowerBound(const std::string& key) const
+	{
+		int low = 0;
+		int high = sparseIndex.size();
+		int middle, index, end;
+
+		//Finds the last block that starts before the key, the key can only be in that block or at the start of the next one.
+		while (low < high)
+		{
+			middle = (low + high) / 2;
+			if (alphabetical(sparseIndex[middle], key))
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		if (low == 0)
+			return 0;
+
+		index = (low - 1) * CATALOGUE_BLOCK_SIZE;
+		end = index + CATALOGUE_BLOCK_SIZE;
+		if (end > (int)entries.size())
+			end = entries.size();
+		while ((index < end) && (compareKey(index, key) < 0))
+			index++;
+		return index;
+	}
+
+	/*
+		function description:
+		Finds the books whose key (title or author) starts with a prefix. The books with the prefix are all next
+		to each other, starting at the lowerBound of the prefix, and so are the copies of each book.
+
+		PARAM: string prefix, the start of the title or author being searched for.
+		PARAM: int limit, the most books to find.
+		PARAM: vector<prefixMatch> matches, the books found are appended in order.
+	*/
+	void findPrefix(const std::string& prefix, int limit, std::vector<prefixMatch>& matches) const
+	{
+		size_t offset, length;
+		int found = 0;
 
-		//If linked list is not empty, iterate through the list trying to find the patrons name.
-		patron = head;
-		while (patron->next != NULL)
+		for (int index = lowerBound(prefix); index < (int)entries.size(); index++)
 		{
-			if (patronName == patron->getName())
+			const catalogueEntry& entry = entries[index];
+
+			offset = (tree == TITLE_TREE) ? entry.titleOffset : entry.authorOffset;
+			length = (tree == TITLE_TREE) ? entry.titleLength : entry.authorLength;
+			if ((length < prefix.length()) || (text.compare(offset, prefix.length(), prefix) != 0))
+				break;
+
+			if ((found != 0) && (text.compare(entry.titleOffset, entry.titleLength, matches.back().title) == 0)
+				&& (text.compare(entry.authorOffset, entry.authorLength, matches.back().author) == 0))
 			{
-				patron->addBook(title, author);
-				return;
+				matches.back().copies++;
+				continue;
+			}
+			if (found == limit)
+				break;
+			matches.push_back(prefixMatch{ getTitle(index), getAuthorName(index), 1 });
+			found++;
+		}
+	}
+
+	int size(void) const
+	{
+		return entries.size();
+	}
+	std::string getTitle(int index) const
+	{
+		return text.substr(entries[index].titleOffset, entries[index].titleLength);
+	}
+	std::string getAuthorName(int index) const
+	{
+		return text.substr(entries[index].authorOffset, entries[index].authorLength);
+	}
+	void writeBook(catalogueWriter& writer, int index) const
+	{
+		const catalogueEntry& entry = entries[index];
+		writer.writeBook(text.data() + entry.titleOffset, entry.titleLength, text.data() + entry.authorOffset, entry.authorLength);
+	}
+
+	/*
+		function description:
+		Returns the number of bytes the arrays have allocated on the heap.
+	*/
+	size_t memoryUsage(void) const
+	{
+		size_t bytes = stringHeapBytes(text) + (entries.capacity() * sizeof(catalogueEntry));
+
+		for (int i = 0; i < (int)sparseIndex.size(); i++)
+			bytes += stringHeapBytes(sparseIndex[i]);
+		return bytes + (sparseIndex.capacity() * sizeof(std::string));
+	}
+};
+
+/*
+	One published version of the catalogue arrays of a bookTree. A version is never changed once it is
+	published, so it can be read without locking the tree, and it is freed when the last reader is done with it.
+*/
+struct catalogueSnapshot
+{
+	catalogueOrder titleCatalogue;
+	catalogueOrder authorCatalogue;
+};
+
+/*
+	class description:
+	A nodeSlab allocates the nodes of one structure (a bookTree or a patronList) from chunks of memory
+	rather than one at a time from the heap, so nodes don't each carry the overhead of a heap allocation,
+	and nodes next to each other in a chunk are usually close together in the tree too. Each structure
+	has its own slab, so the branches loaded on separate threads at startup don't compete for the heap.
+
+	important info:
+	 - The chunks double in size up to MAX_CHUNK_SIZE, so a structure with only a few nodes (such as a
+	 patron with one book) only allocates a small chunk.
+	 - A released node is put on a free list and reused by the next allocate. Nodes never move, so
+	 pointers to them stay valid.
+	 - When the slab is destroyed, each chunk is freed in one step without visiting the nodes, so any
+	 node type with something to clean up (patronNode) must be released by its owner first.
+*/
+template <typename T>
+class nodeSlab
+{
+private:
+	static const size_t FIRST_CHUNK_SIZE = 4;
+	static const size_t MAX_CHUNK_SIZE = 4096;
+
+	//A slot holds a node while it is allocated, and the next free slot while it is on the free list.
+	union slot
+	{
+		slot* nextFree;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	std::vector<std::unique_ptr<slot[]>> chunks;
+	size_t chunkSize = 0;
+	size_t chunkUsed = 0;
+	slot* freeList = NULL;
+
+public:
+	nodeSlab()
+	{
+	}
+	nodeSlab(const nodeSlab&) = delete;
+	nodeSlab& operator=(const nodeSlab&) = delete;
+
+	/*
+		function description:
+		Takes a slot from the free list, or from the current chunk if the free list is empty,
+		and constructs a new node in it.
+
+		RETURN: T*, the new node.
+	*/
+	T* allocate(void)
+	{
+		slot* next;
+
+		if (freeList != NULL)
+		{
+			next = freeList;
+			freeList = freeList->nextFree;
+		}
+		else
+		{
+			if (chunkUsed == chunkSize)
+			{
+				chunkSize = (chunkSize == 0) ? FIRST_CHUNK_SIZE : chunkSize * 2;
+				if (chunkSize > MAX_CHUNK_SIZE)
+					chunkSize = MAX_CHUNK_SIZE;
+				chunks.emplace_back(new slot[chunkSize]);
+				chunkUsed = 0;
 			}
-			patron = patron->next;
+			next = &chunks.back()[chunkUsed++];
+		}
+		return new (next->storage) T();
+	}
+
+	/*
+		function description:
+		Destroys a node and puts its slot on the free list.
+
+		PARAM: T* node, a node that was returned by allocate.
+	*/
+	void release(T* node)
+	{
+		slot* freed = reinterpret_cast<slot*>(node);
+
+		node->~T();
+		freed->nextFree = freeList;
+		freeList = freed;
+	}
+
+	/*
+		function description:
+		Returns the number of bytes the chunks have allocated on the heap.
+	*/
+	size_t memoryUsage(void)
+	{
+		size_t bytes = chunks.capacity() * sizeof(std::unique_ptr<slot[]>);
+		size_t size = FIRST_CHUNK_SIZE;
+
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			bytes += size * sizeof(slot);
+			if (size < MAX_CHUNK_SIZE)
+				size *= 2;
+		}
+		return bytes;
+	}
+};
+
+/*
+	class description:
+	the bookTree class is a binary search tree that contains all the functions which
+	allocate, traverse, access data from, and deallocate bookNodes.
+
+	the bookTree class also does all of the writing back to the spreadsheet .csv files.
+*/
+class bookTree
+{
+private:
+
+	/*
+		function description:
+		Returns the height of a subtree in the selected tree, where an empty subtree has height 0.
+	*/
+	int subtreeHeight(bookNode* node, treeSelect tree)
+	{
+		if (node == NULL)
+			return 0;
+		return node->height(tree);
+	}
+	int subtreeSize(bookNode* node, treeSelect tree)
+	{
+		if (node == NULL)
+			return 0;
+		return node->size(tree);
+	}
+
+	/*
+		function description:
+		Recomputes the height and size of a node in the selected tree from its two subtrees. Every function
+		that relinks a node calls this on the way back up, so the sizes are always kept along with the heights.
+	*/
+	void updateNode(bookNode* node, treeSelect tree)
+	{
+		int leftHeight = subtreeHeight(node->leftLeaf(tree), tree);
+		int rightHeight = subtreeHeight(node->rightLeaf(tree), tree);
+		node->height(tree) = 1 + ((leftHeight > rightHeight) ? leftHeight : rightHeight);
+		node->size(tree) = 1 + subtreeSize(node->leftLeaf(tree), tree) + subtreeSize(node->rightLeaf(tree), tree);
+	}
+
+	/*
+		function description:
+		Rotates a subtree of the selected tree to the left or right.
+
+		PARAM: bookNode* node, the root of the subtree being rotated.
+		PARAM: treeSelect tree, the tree being rotated.
+		RETURN: bookNode*, the new root of the subtree.
+	*/
+	bookNode* rotateLeft(bookNode* node, treeSelect tree)
+	{
+		bookNode* newRoot = node->rightLeaf(tree);
+		node->rightLeaf(tree) = newRoot->leftLeaf(tree);
+		newRoot->leftLeaf(tree) = node;
+		updateNode(node, tree);
+		updateNode(newRoot, tree);
+		return newRoot;
+	}
+	bookNode* rotateRight(bookNode* node, treeSelect tree)
+	{
+		bookNode* newRoot = node->leftLeaf(tree);
+		node->leftLeaf(tree) = newRoot->rightLeaf(tree);
+		newRoot->rightLeaf(tree) = node;
+		updateNode(node, tree);
+		updateNode(newRoot, tree);
+		return newRoot;
+	}
+
+	/*
+		function description:
+		Restores the AVL property at a node after one of its subtrees changed height by at most one.
+
+		PARAM: bookNode* node, the root of the subtree being balanced.
+		PARAM: treeSelect tree, the tree being balanced.
+		RETURN: bookNode*, the new root of the subtree.
+	*/
+	bookNode* balance(bookNode* node, treeSelect tree)
+	{
+		int balanceFactor;
+
+		updateNode(node, tree);
+		balanceFactor = subtreeHeight(node->leftLeaf(tree), tree) - subtreeHeight(node->rightLeaf(tree), tree);
+
+		//Left side is too tall, a left-right case is first turned into a left-left case.
+		if (balanceFactor > 1)
+		{
+			if (subtreeHeight(node->leftLeaf(tree)->leftLeaf(tree), tree) < subtreeHeight(node->leftLeaf(tree)->rightLeaf(tree), tree))
+				node->leftLeaf(tree) = rotateLeft(node->leftLeaf(tree), tree);
+			return rotateRight(node, tree);
+		}
+
+		//Right side is too tall, a right-left case is first turned into a right-right case.
+		if (balanceFactor < -1)
+		{
+			if (subtreeHeight(node->rightLeaf(tree)->rightLeaf(tree), tree) < subtreeHeight(node->rightLeaf(tree)->leftLeaf(tree), tree))
+				node->rightLeaf(tree) = rotateRight(node->rightLeaf(tree), tree);
+			return rotateLeft(node, tree);
+		}
+
+		return node;
+	}
+
+	/*
+		function description:
+		Decides whether node a comes before node b in the selected tree. Books are ordered by the key of
+		the tree, then by the other key, and books with the same title and author are ordered by address.
+		Because no two nodes are equal, a specific node can always be found again to be removed.
+
+		RETURN: bool, true if a comes before b.
+	*/
+	bool nodeBefore(bookNode* a, bookNode* b, treeSelect tree)
+	{
+		treeSelect otherTree = (tree == TITLE_TREE) ? AUTHOR_TREE : TITLE_TREE;
+		int comparison;
+
+		comparison = s_stringPoolObject.compare(a->getKeyHandle(tree), b->getKeyHandle(tree));
+		if (comparison != 0)
+			return comparison < 0;
+		comparison = s_stringPoolObject.compare(a->getKeyHandle(otherTree), b->getKeyHandle(otherTree));
+		if (comparison != 0)
+			return comparison < 0;
+		return std::less<bookNode*>()(a, b);
+	}
+
+	/*
+		function description:
+		Inserts a node into the selected tree in alphabetical order and rebalances on the way back up.
+		The recursion is only as deep as the tree, which is O(log n) because the tree stays balanced.
+
+		PARAM: bookNode* node, the root of the subtree the new node is inserted into.
+		PARAM: bookNode* newnode, the node being inserted.
+		PARAM: treeSelect tree, the tree being inserted into.
+		RETURN: bookNode*, the new root of the subtree.
+	*/
+	bookNode* insertNode(bookNode* node, bookNode* newnode, treeSelect tree)
+	{
+		//base case
+		if (node == NULL)
+			return newnode;
+
+		if (nodeBefore(newnode, node, tree))
+			node->leftLeaf(tree) = insertNode(node->leftLeaf(tree), newnode, tree);
+		else
+			node->rightLeaf(tree) = insertNode(node->rightLeaf(tree), newnode, tree);
+
+		return balance(node, tree);
+	}
+
+	/*
+		function description:
+		Removes the leftmost node from a subtree of the selected tree and rebalances on the way back up.
+
+		PARAM: bookNode* node, the root of the subtree.
+		PARAM: bookNode*& leftmost, set to the node that was removed.
+		PARAM: treeSelect tree, the tree being removed from.
+		RETURN: bookNode*, the new root of the subtree.
+	*/
+	bookNode* removeLeftmost(bookNode* node, bookNode*& leftmost, treeSelect tree)
+	{
+		//base case
+		if (node->leftLeaf(tree) == NULL)
+		{
+			leftmost = node;
+			return node->rightLeaf(tree);
+		}
+
+		node->leftLeaf(tree) = removeLeftmost(node->leftLeaf(tree), leftmost, tree);
+		return balance(node, tree);
+	}
+
+	/*
+		function description:
+		Unlinks a node from the selected tree and rebalances on the way back up. A node with two
+		children is replaced by the leftmost node of its right subtree. The node itself isn't
+		deallocated, because it also has to be unlinked from the other tree.
+
+		PARAM: bookNode* node, the root of the subtree the node is being removed from.
+		PARAM: bookNode* target, the node being removed.
+		PARAM: treeSelect tree, the tree being removed from.
+		RETURN: bookNode*, the new root of the subtree.
+	*/
+	bookNode* removeNode(bookNode* node, bookNode* target, treeSelect tree)
+	{
+		bookNode* replacement;
+
+		//base case, target isn't in the tree
+		if (node == NULL)
+			return NULL;
+
+		if (node == target)
+		{
+			if (node->leftLeaf(tree) == NULL)
+				return node->rightLeaf(tree);
+			if (node->rightLeaf(tree) == NULL)
+				return node->leftLeaf(tree);
+
+			node->rightLeaf(tree) = removeLeftmost(node->rightLeaf(tree), replacement, tree);
+			replacement->leftLeaf(tree) = node->leftLeaf(tree);
+			replacement->rightLeaf(tree) = node->rightLeaf(tree);
+			return balance(replacement, tree);
 		}
-		if (patronName == patron->getName())
+
+		if (nodeBefore(target, node, tree))
+			node->leftLeaf(tree) = removeNode(node->leftLeaf(tree), target, tree);
+		else
+			node->rightLeaf(tree) = removeNode(node->rightLeaf(tree), target, tree);
+		return balance(node, tree);
+	}
+
+	/*
+		function description:
+		Sorts a list of nodes into the order of the selected tree. Nothing is done if the list is already
+		sorted, which it is for the title tree when the .csv file was written by snapshot. Long lists are
+		split into chunks which are sorted on separate threads, then merged in pairs, also in parallel.
+
+		PARAM: vector<bookNode*> nodes, the nodes being sorted.
+		PARAM: treeSelect tree, the tree whose order the nodes are sorted into.
+	*/
+	void sortNodes(std::vector<bookNode*>& nodes, treeSelect tree)
+	{
+		auto before = [this, tree](bookNode* a, bookNode* b) { return nodeBefore(a, b, tree); };
+		size_t chunkCount = nodes.size() / s_sortChunkNodes;
+		size_t threadCount = std::thread::hardware_concurrency();
+		std::vector<size_t> bounds;
+		std::vector<std::thread> threads;
+
+		if (std::is_sorted(nodes.begin(), nodes.end(), before))
+			return;
+
+		if (chunkCount > threadCount)
+			chunkCount = threadCount;
+		if (chunkCount < 2)
 		{
-			patron->addBook(title, author);
+			std::sort(nodes.begin(), nodes.end(), before);
 			return;
 		}
 
-		//If the function hasn't returned yet it means the patron was not in the list, so they are added to the list.
-		newnode = new patronNode;
-		newnode->setName(patronName);
-		newnode->addBook(title, author);
-		patron->next = newnode;
+		for (size_t i = 0; i <= chunkCount; i++)
+			bounds.push_back(nodes.size() * i / chunkCount);
+
+		for (size_t i = 0; i < chunkCount; i++)
+			threads.emplace_back([&nodes, &bounds, before, i]() { std::sort(nodes.begin() + bounds[i], nodes.begin() + bounds[i + 1], before); });
+		for (size_t i = 0; i < threads.size(); i++)
+			threads[i].join();
+
+		//Each pass merges neighbouring pairs of sorted runs, doubling the length of the runs.
+		for (size_t width = 1; width < chunkCount; width *= 2)
+		{
+			threads.clear();
+			for (size_t i = 0; i + width < chunkCount; i += 2 * width)
+			{
+				size_t last = (i + (2 * width) < chunkCount) ? i + (2 * width) : chunkCount;
+				threads.emplace_back([&nodes, &bounds, before, i, width, last]()
+					{ std::inplace_merge(nodes.begin() + bounds[i], nodes.begin() + bounds[i + width], nodes.begin() + bounds[last], before); });
+			}
+			for (size_t i = 0; i < threads.size(); i++)
+				threads[i].join();
+		}
 	}
 
 	/*
 		function description:
-		checks in a book (removes from the patron list) by traversing through all users and thier respective binary search trees trying
-		to find the book (defined by the parameters title and author). Returns true and sets the delete flag if it is found,
-		returns false if a checked out book is not found matching the parameters.
+		Links a sorted list of nodes into a perfectly balanced subtree of the selected tree, from the
+		bottom up. The middle node is the root, and the nodes either side of it form the subtrees,
+		so every node is visited once and the tree is built in O(n).
+
+		PARAM: vector<bookNode*> nodes, the nodes in the order of the selected tree.
+		PARAM: size_t begin, the first node of the subtree.
+		PARAM: size_t end, one past the last node of the subtree.
+		PARAM: treeSelect tree, the tree being built.
+		RETURN: bookNode*, the root of the subtree.
+	*/
+	bookNode* buildBalanced(std::vector<bookNode*>& nodes, size_t begin, size_t end, treeSelect tree)
+	{
+		size_t middle;
+		bookNode* node;
 
-		PARAM: string title, title of the book to check back in.
-		PARAM: string author, author of the book to check back in.
-		RETURN: bool indicates whether a book was found and deleted or not.
+		//base case
+		if (begin == end)
+			return NULL;
+
+		middle = begin + ((end - begin) / 2);
+		node = nodes[middle];
+		node->leftLeaf(tree) = buildBalanced(nodes, begin, middle, tree);
+		node->rightLeaf(tree) = buildBalanced(nodes, middle + 1, end, tree);
+		updateNode(node, tree);
+		return node;
+	}
+
+protected:
+	//The title tree and the author tree are balanced separately, so they each have their own root.
+	bookNode* titleRoot;
+	bookNode* authorRoot;
+
+	//Every node of the trees is allocated from this slab, so the trees are deallocated with the slab.
+	nodeSlab<bookNode> slab;
+
+	//The latest version of the sorted array copies of the two trees used to print the catalogue, only ever
+	//read and replaced with std::atomic_load and std::atomic_store. After any book is added or deleted the
+	//dirty flag is set, and the next reader publishes a new version, so a burst of changes is only copied once.
+	std::shared_ptr<const catalogueSnapshot> catalogue;
+	std::atomic<bool> catalogueDirtyFlag{ true };
+
+	//Held while a new version of the catalogue is built, so two readers don't build the same version.
+	std::mutex catalogueMutex;
+
+	//Exact match index from the title and author of a book to every copy of that book,
+	//so a book can be found without searching the trees.
+	std::unordered_multimap<bookKey, bookNode*, bookKeyHash> bookIndex;
+
+	/*
+		function description:
+		Appends the nodes of the selected tree to a list in order.
 	*/
-	bool checkIn(std::string title, std::string author)
+	void collectInOrder(std::vector<bookNode*>& nodes, treeSelect tree)
 	{
-		patronNode* patron;
-		patron = head;
+		std::vector<bookNode*> stack;
+		bookNode* node = (tree == TITLE_TREE) ? titleRoot : authorRoot;
 
-		while (!patron->deleteBook(title, author))
+		while ((node != NULL) || !stack.empty())
 		{
-			patron = patron->next;
-			if (patron == NULL)
-				return false;
+			while (node != NULL)
+			{
+				stack.push_back(node);
+				node = node->leftLeaf(tree);
+			}
+			node = stack.back();
+			stack.pop_back();
+			nodes.push_back(node);
+			node = node->rightLeaf(tree);
 		}
-		return true;
 	}
 
 	/*
 		function description:
-		writes back the list to the .csv file containing data on the checked out books.
+		Appends the books to the sections of a binary snapshot. There is one record per book in order of
+		title, then an array with the order of the records in the title tree and one with their order in
+		the author tree, so that the trees can be rebuilt without sorting. An entry of an order array has
+		s_copyOfPreviousBit set if the book has the same title and author as the entry before it.
+
+		PARAM: string records, the offset and length of the title and author of each book are appended.
+		PARAM: string orders, the title order array then the author order array are appended.
+		PARAM: string pool, the text of the titles and authors is appended.
+		PARAM: unordered_map<string, uint32_t> pooledAuthors, the authors already in the pool.
+		RETURN: uint32_t, the number of books.
+	*/
+	uint32_t appendBinaryBooks(std::string& records, std::string& orders, std::string& pool, std::unordered_map<std::string, uint32_t>& pooledAuthors)
+	{
+		std::vector<bookNode*> nodes;
+		std::unordered_map<bookNode*, uint32_t> titlePosition;
+		uint32_t entry;
+
+		for (int i = 0; i < 2; i++)
+		{
+			treeSelect tree = (i == 0) ? TITLE_TREE : AUTHOR_TREE;
+
+			nodes.clear();
+			collectInOrder(nodes, tree);
+			for (uint32_t j = 0; j < (uint32_t)nodes.size(); j++)
+			{
+				if (tree == TITLE_TREE)
+				{
+					titlePosition[nodes[j]] = j;
+					appendBinaryString(records, pool, nodes[j]->getTitle(), NULL);
+					appendBinaryString(records, pool, nodes[j]->getAuthorName(), &pooledAuthors);
+					entry = j;
+				}
+				else
+					entry = titlePosition[nodes[j]];
+
+				if ((j != 0) && (nodes[j]->getBookKey() == nodes[j - 1]->getBookKey()))
+					entry |= s_copyOfPreviousBit;
+				appendBinaryValue<uint32_t>(orders, entry);
+			}
+		}
+		return (uint32_t)nodes.size();
+	}
+
+	/*
+		function description:
+		Links new nodes into both trees using the order arrays of a binary snapshot, without comparing any
+		titles or authors. Copies of the same book are ordered by address in the trees, and the new nodes
+		don't have the addresses the old ones did, so only the runs of copies are sorted again.
+
+		PARAM: vector<bookNode*> nodes, the new nodes, in the order of the records.
+		PARAM: vector<uint32_t> titleOrder, the title order array.
+		PARAM: vector<uint32_t> authorOrder, the author order array.
+	*/
+	void buildFromOrders(const std::vector<bookNode*>& nodes, const std::vector<uint32_t>& titleOrder, const std::vector<uint32_t>& authorOrder)
+	{
+		std::vector<bookNode*> ordered(nodes.size());
+		size_t runStart;
+
+		for (int i = 0; i < 2; i++)
+		{
+			treeSelect tree = (i == 0) ? TITLE_TREE : AUTHOR_TREE;
+			const std::vector<uint32_t>& order = (i == 0) ? titleOrder : authorOrder;
+
+			for (size_t j = 0; j < nodes.size(); j++)
+				ordered[j] = nodes[order[j] & ~s_copyOfPreviousBit];
+
+			for (size_t j = 1; j < nodes.size(); j++)
+			{
+				if (!(order[j] & s_copyOfPreviousBit))
+					continue;
+				runStart = j - 1;
+				while ((j < nodes.size()) && (order[j] & s_copyOfPreviousBit))
+					j++;
+				std::sort(ordered.begin() + runStart, ordered.begin() + j, std::less<bookNode*>());
+			}
+
+			if (tree == TITLE_TREE)
+				titleRoot = buildBalanced(ordered, 0, ordered.size(), TITLE_TREE);
+			else
+				authorRoot = buildBalanced(ordered, 0, ordered.size(), AUTHOR_TREE);
+		}
+		catalogueDirtyFlag = true;
+	}
+
+	/*
+		function description:
+		Appends the books to a buffer as the lines of a .csv file, in order of title, so that the next
+		time the file is loaded it is already sorted for bulkLoad.
+
+		PARAM: string buffer, the .csv lines are appended to this buffer.
+		PARAM: string* lastField, a field added to the end of every line, or NULL for none.
+	*/
+	void appendInOrder(std::string& buffer, const std::string* lastField)
+	{
+		std::vector<bookNode*> stack;
+		bookNode* node = titleRoot;
+
+		while ((node != NULL) || !stack.empty())
+		{
+			while (node != NULL)
+			{
+				stack.push_back(node);
+				node = node->leftLeafTitle;
+			}
+			node = stack.back();
+			stack.pop_back();
+
+			appendCsvField(buffer, node->getTitle());
+			buffer += ',';
+			appendCsvField(buffer, node->getAuthorName());
+			if (lastField != NULL)
+			{
+				buffer += ',';
+				appendCsvField(buffer, *lastField);
+			}
+			buffer += '\n';
+			node = node->rightLeafTitle;
+		}
+	}
+
+	/*
+		function description:
+		Publishes a new version of the catalogue if the trees have changed since the last one was published.
+		The trees must be locked for reading. If another reader is already building the new version and wait
+		is false, the last version is returned rather than waiting for it.
+
+		RETURN: the latest published version of the catalogue (NULL if none has been published yet).
+	*/
+	std::shared_ptr<const catalogueSnapshot> refreshCatalogue(bool wait)
+	{
+		std::unique_lock<std::mutex> lock(catalogueMutex, std::defer_lock);
+		std::shared_ptr<catalogueSnapshot> version;
+
+		if (wait)
+			lock.lock();
+		else if (!lock.try_lock())
+			return std::atomic_load(&catalogue);
+
+		if (catalogueDirtyFlag)
+		{
+			version = std::make_shared<catalogueSnapshot>();
+			version->titleCatalogue.build(titleRoot, TITLE_TREE);
+			version->authorCatalogue.build(authorRoot, AUTHOR_TREE);
+			std::atomic_store(&catalogue, std::shared_ptr<const catalogueSnapshot>(version));
+			catalogueDirtyFlag = false;
+		}
+		return std::atomic_load(&catalogue);
+	}
+
+	/*
+		function description:
+		Prints the books of a published version of the catalogue, starting from the first book that does not come
+		before startKey. The catalogue can be printed in pages, and since the catalogue is an array the first book
+		of a page is found by its position without reading the books before it. The tree doesn't need to be locked.
+
+		PARAM: catalogueSnapshot version, the version of the catalogue to print.
+		PARAM: string select, selection for title or author.
+		PARAM: string startKey, the title or author to start printing from (empty prints every book).
+		PARAM: int page, the page to print, starting from 1.
+		PARAM: int pageSize, the number of books on each page (0 prints every book from startKey on one page).
+	*/
+	void printCatalogue(const catalogueSnapshot& version, std::string select, std::string startKey, int page = 1, int pageSize = 0)
+	{
+		const catalogueOrder* catalogue;
+		catalogueWriter writer;
+		int first, begin, end;
+
+		if (select == "title")
+			catalogue = &version.titleCatalogue;
+		else if (select == "author")
+			catalogue = &version.authorCatalogue;
+		else
+		{
+			std::cout << "incorrect selection, must be 'title' or 'author'";
+			return;
+		}
+
+		first = catalogue->lowerBound(startKey);
+		pageBounds(first, catalogue->size(), page, pageSize, begin, end);
+
+		for (int i = begin; i < end; i++)
+			catalogue->writeBook(writer, i);
+
+		if (pageSize > 0)
+			writer.writeLine(pageLine(first, catalogue->size(), page, pageSize));
+	}
+
+	/*
+		function description:
+		Appends one page of the books to a buffer straight from the tree, starting from the first book that does
+		not come before startKey. The first book of the page is found with rankOf and seekNode, so only the books
+		on the page are read, and the catalogue doesn't need to be published first. The tree must be locked for
+		reading, and the buffer is printed after unlocking, so the lock isn't held while writing to the console.
+
+		PARAM: string buffer, the lines of the page are appended to this buffer.
+		PARAM: string select, selection for title or author.
+		PARAM: string startKey, the title or author to start printing from (empty prints every book).
+		PARAM: int page, the page to print, starting from 1.
+		PARAM: int pageSize, the number of books on each page.
+	*/
+	void appendTreePage(std::string& buffer, std::string select, std::string startKey, int page, int pageSize)
+	{
+		treeSelect tree;
+		std::vector<bookNode*> stack;
+		bookNode* node;
+		const std::string* title;
+		const std::string* author;
+		int first, begin, end;
+
+		if (select == "title")
+			tree = TITLE_TREE;
+		else if (select == "author")
+			tree = AUTHOR_TREE;
+		else
+		{
+			buffer += "incorrect selection, must be 'title' or 'author'";
+			return;
+		}
+
+		first = rankOf(startKey, tree);
+		pageBounds(first, bookCount(), page, pageSize, begin, end);
+
+		//The stack is left holding the nodes the search turned left at, which are the next books in order.
+		seekNode(begin, tree, stack);
+		for (int i = begin; i < end; i++)
+		{
+			node = stack.back();
+			stack.pop_back();
+			title = &node->getTitle();
+			author = &node->getAuthorName();
+			catalogueWriter::appendBook(buffer, title->data(), title->length(), author->data(), author->length());
+
+			for (node = node->rightLeaf(tree); node != NULL; node = node->leftLeaf(tree))
+				stack.push_back(node);
+		}
+
+		if (pageSize > 0)
+			buffer += pageLine(first, bookCount(), page, pageSize) + "\n";
+	}
+
+	/*
+		function description:
+		Finds the books on a page of the catalogue by their position, for a catalogue of count books where
+		the page starts counting from position first.
+
+		PARAM: int begin, set to the position of the first book on the page.
+		PARAM: int end, set to one past the position of the last book on the page.
+	*/
+	static void pageBounds(int first, int count, int page, int pageSize, int& begin, int& end)
+	{
+		begin = first;
+		end = count;
+		if (pageSize > 0)
+		{
+			begin = first + (int)std::min<long long>((long long)(page - 1) * pageSize, end - first);
+			end = std::min(begin + pageSize, end);
+		}
+	}
+
+	/*
+		function description:
+		Returns the line printed under a page of the catalogue, which gives the page number and the number
+		of pages, or says that the page doesn't exist if it is past the last page.
+	*/
+	static std::string pageLine(int first, int count, int page, int pageSize)
+	{
+		int pageCount = (count - first + pageSize - 1) / pageSize;
+
+		if (pageCount == 0)
+			return "          There is no page " + std::to_string(page) + ", there are no books to list";
+		if (page > pageCount)
+			return "          There is no page " + std::to_string(page) + ", there " + ((pageCount == 1) ? "is only 1 page" : "are only " + std::to_string(pageCount) + " pages");
+		return "          Page " + std::to_string(page) + " of " + std::to_string(pageCount);
+	}
+
+	/*
+		function description:
+		Searches the selected tree for the k-th book by its position, using the subtree sizes to decide
+		which way to go at each node. The nodes the search turned left at are pushed onto the stack, so
+		the top of the stack is the k-th book and the in order traversal can carry on from there.
+
+		PARAM: int k, the position of the book, starting from 0.
+		PARAM: treeSelect tree, the tree being searched.
+		PARAM: vector<bookNode*> stack, the path to the book is pushed here (left empty if k is past the last book).
+	*/
+	void seekNode(int k, treeSelect tree, std::vector<bookNode*>& stack)
+	{
+		bookNode* node = (tree == TITLE_TREE) ? titleRoot : authorRoot;
+		int leftSize;
+
+		if ((k < 0) || (k >= subtreeSize(node, tree)))
+			return;
+
+		while (node != NULL)
+		{
+			leftSize = subtreeSize(node->leftLeaf(tree), tree);
+			if (k < leftSize)
+			{
+				stack.push_back(node);
+				node = node->leftLeaf(tree);
+			}
+			else if (k == leftSize)
+			{
+				stack.push_back(node);
+				return;
+			}
+			else
+			{
+				k -= leftSize + 1;
+				node = node->rightLeaf(tree);
+			}
+		}
+	}
+
+public:
+	bookTree()
+	{
+		titleRoot = NULL;
+		authorRoot = NULL;
+	}
+
+	/*
+		function description:
+		Appends the lines of the books in bookTree to a buffer, in either alphabetical order based off of the
+		book title, or the authors name. The lines are read straight from the tree, so a small tree (such as
+		a patron's) doesn't publish a catalogue. The tree must be locked for reading, and the buffer is printed
+		after unlocking, so the lock isn't held while writing to the console.
+
+		PARAM: string buffer: the lines are appended to this buffer.
+		PARAM: string select: the selection for which alphabetical order (must be 'title' or 'author')
+	*/
+	void appendList(std::string& buffer, std::string select)
+	{
+		treeSelect tree = (select == "author") ? AUTHOR_TREE : TITLE_TREE;
+		std::vector<bookNode*> stack;
+		bookNode* node = (tree == TITLE_TREE) ? titleRoot : authorRoot;
+		const std::string* title;
+		const std::string* author;
+
+		while ((node != NULL) || !stack.empty())
+		{
+			while (node != NULL)
+			{
+				stack.push_back(node);
+				node = node->leftLeaf(tree);
+			}
+			node = stack.back();
+			stack.pop_back();
+
+			title = &node->getTitle();
+			author = &node->getAuthorName();
+			catalogueWriter::appendBook(buffer, title->data(), title->length(), author->data(), author->length());
+			node = node->rightLeaf(tree);
+		}
+	}
+
+	/*
+		function description:
+		Returns the rank of a title or author in the selected tree, which is the number of books whose key
+		comes before it, in O(log n). The tree must be locked for reading.
+
+		PARAM: string key, the title or author being ranked.
+		PARAM: treeSelect tree, the tree the key is ranked in.
+		RETURN: integer, the position of the first book at or after the key.
+	*/
+	int rankOf(const std::string& key, treeSelect tree)
+	{
+		bookNode* node = (tree == TITLE_TREE) ? titleRoot : authorRoot;
+		int rank = 0;
+
+		while (node != NULL)
+		{
+			if (alphabetical(node->getKey(tree), key))
+			{
+				rank += subtreeSize(node->leftLeaf(tree), tree) + 1;
+				node = node->rightLeaf(tree);
+			}
+			else
+				node = node->leftLeaf(tree);
+		}
+		return rank;
+	}
+
+	int bookCount(void)
+	{
+		return subtreeSize(titleRoot, TITLE_TREE);
+	}
+
+	/*
+		function description:
+		Finds the books in the selected tree whose key (title or author) starts with a prefix. The search seeks
+		to the rank of the prefix and walks forward until a key doesn't start with it, so it only reads the
+		books it finds, plus their copies. The tree must be locked for reading.
+
+		PARAM: string prefix, the start of the title or author being searched for.
+		PARAM: treeSelect tree, the tree being searched.
+		PARAM: int limit, the most books to find.
+		PARAM: vector<prefixMatch> matches, the books found are appended in order.
+	*/
+	void findPrefix(const std::string& prefix, treeSelect tree, int limit, std::vector<prefixMatch>& matches)
+	{
+		std::vector<bookNode*> stack;
+		bookNode* node;
+		bookKey lastKey;
+		int found = 0;
+
+		seekNode(rankOf(prefix, tree), tree, stack);
+		while (!stack.empty())
+		{
+			node = stack.back();
+			stack.pop_back();
+			if (node->getKey(tree).compare(0, prefix.length(), prefix) != 0)
+				break;
+
+			if ((found != 0) && (node->getBookKey() == lastKey))
+				matches.back().copies++;
+			else if (found == limit)
+				break;
+			else
+			{
+				matches.push_back(prefixMatch{ node->getTitle(), node->getAuthorName(), 1 });
+				lastKey = node->getBookKey();
+				found++;
+			}
+
+			for (node = node->rightLeaf(tree); node != NULL; node = node->leftLeaf(tree))
+				stack.push_back(node);
+		}
+	}
+
+	/*
+		function description:
+		Adds a book to both the title tree and the author tree. Both trees are rebalanced
+		after the insert, so the insert is O(log n) no matter what order the books come in.
+
+		PARAM: string title, the title of the book being added.
+		PARAM: string author, the author of the book being added.
+	*/
+	void addBook(std::string title, std::string author)
+	{
+		bookNode* newnode;
+
+		newnode = slab.allocate();
+		newnode->assign(title, author);
+
+		titleRoot = insertNode(titleRoot, newnode, TITLE_TREE);
+		authorRoot = insertNode(authorRoot, newnode, AUTHOR_TREE);
+		bookIndex.insert(std::make_pair(newnode->getBookKey(), newnode));
+		catalogueDirtyFlag = true;
+	}
+
+	/*
+		function description:
+		Adds many books at once, such as when a .csv file is loaded, with mergeNodes.
+
+		PARAM: vector<string> fields, the title and author of each book, one after the other.
+	*/
+	void bulkLoad(const std::vector<std::string>& fields)
+	{
+		std::vector<bookNode*> batch;
+
+		batch.reserve(fields.size() / 2);
+		for (size_t i = 0; i + 1 < fields.size(); i += 2)
+		{
+			batch.push_back(slab.allocate());
+			batch.back()->assign(fields[i], fields[i + 1]);
+		}
+		mergeNodes(batch);
+	}
+
+	/*
+		function description:
+		Adds a batch of nodes allocated from the slab to both trees and the exact match index. The batch is
+		sorted once for each tree. A small batch is then inserted in that order, so each insert follows a path
+		next to the last one. A batch that is large compared to the trees is merged in one pass with the nodes
+		already in the trees, and both trees are rebuilt perfectly balanced, which is O(n) after the sort.
+
+		PARAM: vector<bookNode*> batch, the nodes being added, their links are overwritten.
+	*/
+	void mergeNodes(std::vector<bookNode*>& batch)
+	{
+		std::vector<bookNode*> nodes;
+		size_t existing = bookIndex.size();
+		size_t depth = 1;
+
+		for (size_t n = existing; n > 1; n >>= 1)
+			depth++;
+
+		bookIndex.reserve(existing + batch.size());
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			batch[i]->leftLeafTitle = batch[i]->rightLeafTitle = NULL;
+			batch[i]->leftLeafAuthor = batch[i]->rightLeafAuthor = NULL;
+			batch[i]->heightTitle = batch[i]->heightAuthor = 1;
+			batch[i]->sizeTitle = batch[i]->sizeAuthor = 1;
+			bookIndex.insert(std::make_pair(batch[i]->getBookKey(), batch[i]));
+		}
+
+		for (int t = 0; t < 2; t++)
+		{
+			treeSelect tree = (t == 0) ? TITLE_TREE : AUTHOR_TREE;
+			bookNode*& root = (t == 0) ? titleRoot : authorRoot;
+
+			sortNodes(batch, tree);
+			if (batch.size() * depth < existing)
+			{
+				for (size_t i = 0; i < batch.size(); i++)
+					root = insertNode(root, batch[i], tree);
+				continue;
+			}
+
+			nodes.clear();
+			nodes.reserve(existing + batch.size());
+			collectInOrder(nodes, tree);
+			nodes.insert(nodes.end(), batch.begin(), batch.end());
+			std::inplace_merge(nodes.begin(), nodes.begin() + existing, nodes.end(),
+				[this, tree](bookNode* a, bookNode* b) { return nodeBefore(a, b, tree); });
+			root = buildBalanced(nodes, 0, nodes.size(), tree);
+		}
+		catalogueDirtyFlag = true;
+	}
+
+	/*
+		function description:
+		Deletes a book from the binary search tree. The book is found with one probe of the exact match
+		index, so only a copy with both the same title and the same author is deleted. The node is then
+		unlinked from both the title tree and the author tree and deallocated, so the trees only ever
+		hold the books that are actually in the library.
+
+		PARAM: string title, the title of the book being deleted.
+		PARAM: string author, the author of the book being deleted.
+		RETURN: bool, an indicator of whether a book with the given parameters
+		was actually deleted (if no book matches the parameters, false is returned)
+	*/
+	bool deleteBook(std::string title, std::string author)
+	{
+		std::unordered_multimap<bookKey, bookNode*, bookKeyHash>::iterator match;
+		bookNode* node;
+		bookKey key;
+
+		if (!bookKey::find(title, author, key))
+			return false;
+		match = bookIndex.find(key);
+		if (match == bookIndex.end())
+			return false;
+
+		node = match->second;
+		bookIndex.erase(match);
+
+		titleRoot = removeNode(titleRoot, node, TITLE_TREE);
+		authorRoot = removeNode(authorRoot, node, AUTHOR_TREE);
+		slab.release(node);
+
+		catalogueDirtyFlag = true;
+		return true;
+	}
+
+	/*
+		function description:
+		Estimates the number of bytes the node slab, the exact match index, and the catalogue arrays
+		have allocated on the heap. The hash index is estimated as one node per book plus the buckets.
+		The titles and authors are in the string pool, which is counted separately.
+
+		RETURN: size_t, the estimated number of bytes.
+	*/
+	size_t memoryUsage(void)
+	{
+		std::shared_ptr<const catalogueSnapshot> version = std::atomic_load(&catalogue);
+		size_t bytes = slab.memoryUsage();
+
+		bytes += bookIndex.size() * (sizeof(std::pair<const bookKey, bookNode*>) + (2 * sizeof(void*)));
+		bytes += bookIndex.bucket_count() * sizeof(void*);
+
+		if (version)
+			bytes += version->titleCatalogue.memoryUsage() + version->authorCatalogue.memoryUsage();
+		return bytes;
+	}
+
+	/*
+		function description:
+		Copies the books in the binary search tree into a buffer as the lines of a .csv file, so that
+		the file can be written after the lock on the tree has been released.
+
+		PARAM: string buffer, the .csv lines are appended to this buffer.
+	*/
+	void snapshot(std::string& buffer)
+	{
+		appendInOrder(buffer, NULL);
+	}
+
+};
+
+/*
+	class description:
+	Inherits from the bookTree class, also keeps track of a patron name in addition to
+	the title and author parameters. The patron name is also included in the .csv file.
+*/
+class patronNode : public bookTree
+{
+private:
+	uint32_t name;
+public:
+	patronNode* next = NULL;
+
+	void setName(const std::string& Name)
+	{
+		name = s_stringPoolObject.intern(Name);
+	}
+	const std::string& getName(void)
+	{
+		return s_stringPoolObject.get(name);
+	}
+	uint32_t getNameHandle(void)
+	{
+		return name;
+	}
+
+	/*
+		Similar function as used for just the book tree class, except the lines
+		also have the patron name.
+	*/
+	void patronSnapshot(std::string& buffer)
+	{
+		appendInOrder(buffer, &getName());
+	}
+
+	/*
+		function description:
+		Appends a record for each book the patron has checked out to a binary snapshot, with the
+		offset and length of the title, author, and patron name in the string pool.
+
+		PARAM: string records, the records are appended to this buffer.
+		PARAM: string pool, the text of the titles, authors, and name is appended.
+		PARAM: unordered_map<string, uint32_t> pooledNames, the authors and patron names already in the pool.
+		RETURN: uint32_t, the number of records appended.
+	*/
+	uint32_t appendBinaryLoans(std::string& records, std::string& pool, std::unordered_map<std::string, uint32_t>& pooledNames)
+	{
+		std::vector<bookNode*> nodes;
+
+		collectInOrder(nodes, TITLE_TREE);
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			appendBinaryString(records, pool, nodes[i]->getTitle(), NULL);
+			appendBinaryString(records, pool, nodes[i]->getAuthorName(), &pooledNames);
+			appendBinaryString(records, pool, getName(), &pooledNames);
+		}
+		return (uint32_t)nodes.size();
+	}
+
+};
+
+/*
+	class description:
+	the patronList class does all operations that allocate, traverse, access data from, and deallocate
+	from a linked list of patronNodes.
+*/
+class patronList
+{
+private:
+	patronNode* head;
+	patronNode* tail;
+	std::string writebackFilename;
+
+	//Set whenever a book is checked out or in, so the list is only written back when it has changed.
+	bool dirtyFlag = false;
+
+	//The sequence number of the last write ahead log record included in the .csv file.
+	long long checkpointSequence = 0;
+
+	//Set when a binary snapshot is written back, until the .csv file is exported again.
+	bool csvOutdatedFlag = false;
+
+	//Set when the .csv file was changed outside the program but wasn't read, so it is never overwritten.
+	bool csvKeptFlag = false;
+
+	//Finds a patron by name without traversing the linked list. The linked list is still
+	//kept so that patrons are printed and written back in the order they were added.
+	std::unordered_map<uint32_t, patronNode*> patronIndex;
+
+	//Reverse index from a checked out book to the patron that has it, one entry per loan.
+	std::unordered_multimap<bookKey, patronNode*, bookKeyHash> loanIndex;
+
+	//The checked out books in order of title, with the number of copies checked out, so the books with
+	//a title starting with a prefix are found with one search rather than by searching every patron.
+	std::map<bookKey, int, bookKeyTitleLess> loanOrder;
+
+	//Every patronNode in the list is allocated from this slab.
+	nodeSlab<patronNode> slab;
+
+	//Locked for reading while the loans are printed or searched, and for writing while books are checked out or in.
+	std::shared_timed_mutex loanMutex;
+
+public:
+	patronList(std::string WritebackFilename)
+	{
+		writebackFilename = WritebackFilename;
+		head = NULL;
+		tail = NULL;
+	}
+
+	/*
+		function description:
+		Lists the checked out books by traversing the linked list and appending the patron (book tree) in each node
+		to a buffer. The list must be locked for reading, and the buffer is printed after unlocking, so checkouts
+		don't wait on the console.
+
+		PARAM: string buffer, the list is appended to this buffer.
+		PARAM: string select, selects whether to list alphabetically according to title or author.
+	*/
+	void appendList(std::string& buffer, std::string select)
+	{
+		patronNode* traversal;
+		traversal = head;
+
+		while (traversal != NULL)
+		{
+			buffer += traversal->getName() + " has the following books checked out:\n";
+			traversal->appendList(buffer, select);
+			buffer += '\n';
+			traversal = traversal->next;
+		}
+	}
+
+	/*
+		function description:
+		Checks out a book (adds to the patron list) by looking the patron up in the patron index to see whether the patron
+		who is checking a book out is already in the system. If they are in the system, the book is added to their binary
+		search tree. If they are not in the system, a patron node is allocated, assigned the parameters, and added to the
+		end of the linked list.
+
+		PARAM: string title, title of the book being checked out.
+		PARAM: string author, author of the book being checked out.
+		PARAM: patronName, name of the patron checking the book out.
+	*/
+	void checkOut(std::string title, std::string author, std::string patronName)
+	{
+		std::unordered_map<uint32_t, patronNode*>::iterator patron;
+		patronNode* newnode;
+		uint32_t nameHandle = s_stringPoolObject.intern(patronName);
+
+		dirtyFlag = true;
+
+		patron = patronIndex.find(nameHandle);
+		if (patron != patronIndex.end())
+		{
+			patron->second->addBook(title, author);
+			loanIndex.insert(std::make_pair(bookKey::intern(title, author), patron->second));
+			loanOrder[bookKey::intern(title, author)]++;
+			return;
+		}
+
+		//If the function hasn't returned yet it means the patron was not in the list, so they are added to the list.
+		newnode = slab.allocate();
+		newnode->setName(patronName);
+		newnode->addBook(title, author);
+		patronIndex[nameHandle] = newnode;
+		loanIndex.insert(std::make_pair(bookKey::intern(title, author), newnode));
+		loanOrder[bookKey::intern(title, author)]++;
+
+		if (head == NULL)
+			head = newnode;
+		else
+			tail->next = newnode;
+		tail = newnode;
+	}
+
+	/*
+		function description:
+		Prints how much memory the patrons use, in total and on average per patron, so that
+		the memory needed for a given number of patrons can be estimated.
+	*/
+	void printMemoryUsage(void)
+	{
+		patronNode* traversal;
+		size_t bytes;
+		size_t patronCount = patronIndex.size();
+
+		//Patron index, loan index, and the slab of patron nodes.
+		bytes = slab.memoryUsage() + (patronIndex.bucket_count() * sizeof(void*)) + (patronCount * (sizeof(std::pair<const uint32_t, patronNode*>) + (2 * sizeof(void*))));
+		bytes += (loanIndex.bucket_count() * sizeof(void*)) + (loanIndex.size() * (sizeof(std::pair<const bookKey, patronNode*>) + (2 * sizeof(void*))));
+		bytes += loanOrder.size() * (sizeof(std::pair<const bookKey, int>) + (4 * sizeof(void*)));
+
+		traversal = head;
+		while (traversal != NULL)
+		{
+			bytes += traversal->memoryUsage();
+			traversal = traversal->next;
+		}
+
+		std::cout << "          Patrons: " << patronCount << std::endl;
+		std::cout << "          Total memory used by patrons: " << bytes << " bytes" << std::endl;
+		if (patronCount != 0)
+			std::cout << "          Average memory used per patron: " << (bytes / patronCount) << " bytes" << std::endl;
+		std::cout << "          Memory used by the string pool shared by every book and patron: " << s_stringPoolObject.memoryUsage() << " bytes" << std::endl;
+	}
+
+	/*
+		function description:
+		checks in a book (removes from the patron list) by looking up the patron who has the book (defined by the
+		parameters title and author) in the loan index, then deleting it from that patron's binary search tree.
+		Returns true if it is found, returns false if a checked out book is not found matching the parameters.
+
+		PARAM: string title, title of the book to check back in.
+		PARAM: string author, author of the book to check back in.
+		RETURN: bool indicates whether a book was found and deleted or not.
+	*/
+	bool checkIn(std::string title, std::string author)
+	{
+		std::unordered_multimap<bookKey, patronNode*, bookKeyHash>::iterator loan;
+		bookKey key;
+
+		if (!bookKey::find(title, author, key))
+			return false;
+		loan = loanIndex.find(key);
+		if (loan == loanIndex.end())
+			return false;
+
+		loan->second->deleteBook(title, author);
+		loanIndex.erase(loan);
+		if (--loanOrder[key] == 0)
+			loanOrder.erase(key);
+		dirtyFlag = true;
+		return true;
+	}
+
+	/*
+		function description:
+		Finds the names of every patron who has a copy of a book checked out.
+
+		PARAM: string title, title of the book.
+		PARAM: string author, author of the book.
+		RETURN: vector of strings, the names of the patrons (empty if nobody has the book).
+	*/
+	std::vector<std::string> whoHasBook(std::string title, std::string author)
+	{
+		std::pair<std::unordered_multimap<bookKey, patronNode*, bookKeyHash>::iterator,
+			std::unordered_multimap<bookKey, patronNode*, bookKeyHash>::iterator> loans;
+		std::vector<std::string> names;
+		bookKey key;
+
+		if (!bookKey::find(title, author, key))
+			return names;
+		loans = loanIndex.equal_range(key);
+		for (; loans.first != loans.second; loans.first++)
+			names.push_back(loans.first->second->getName());
+		return names;
+	}
+
+	/*
+		function description:
+		Finds the checked out books whose title starts with a prefix. The books with the prefix are next to each
+		other in the loan order, starting at the first title at or after the prefix, so only the books found are
+		read. A book checked out by more than one patron is listed once, with the number of copies checked out.
+
+		PARAM: string prefix, the start of the title being searched for.
+		PARAM: int limit, the most books to find.
+		RETURN: vector of prefixMatch, the books found in order of title.
+	*/
+	std::vector<prefixMatch> findPrefix(const std::string& prefix, int limit)
+	{
+		std::map<bookKey, int, bookKeyTitleLess>::iterator book;
+		std::vector<prefixMatch> matches;
+
+		for (book = loanOrder.lower_bound(prefix); (book != loanOrder.end()) && ((int)matches.size() < limit); book++)
+		{
+			const std::string& title = s_stringPoolObject.get(book->first.title);
+
+			if (title.compare(0, prefix.length(), prefix) != 0)
+				break;
+			matches.push_back(prefixMatch{ title, s_stringPoolObject.get(book->first.authorName), book->second });
+		}
+		return matches;
+	}
+
+	/*
+		function description:
+		If the list has changed since it was last written back, copies it into a buffer as a binary snapshot
+		or as the lines of its .csv file, depending on s_binarySnapshotFlag, and clears the dirty flag.
+
+		PARAM: string buffer, the snapshot is appended to this buffer.
+		PARAM: long long sequence, the sequence number of the last write ahead log record.
+		RETURN: bool, true if the list had changed and was copied into the buffer.
+	*/
+	bool takeSnapshot(std::string& buffer, long long sequence)
+	{
+		if (!dirtyFlag)
+			return false;
+
+		if (s_binarySnapshotFlag)
+		{
+			takeBinarySnapshot(buffer, sequence);
+			csvOutdatedFlag = true;
+		}
+		else
+			takeCsvSnapshot(buffer, sequence);
+
+		checkpointSequence = sequence;
+		dirtyFlag = false;
+		return true;
+	}
+
+	/*
+		function description:
+		Copies the list into a buffer as the lines of the .csv file containing data on the checked out books.
+		The last line records the sequence number of the last write ahead log record that the copy includes.
+
+		PARAM: string buffer, the .csv lines are appended to this buffer.
+		PARAM: long long sequence, the sequence number of the last write ahead log record.
+	*/
+	void takeCsvSnapshot(std::string& buffer, long long sequence)
+	{
+		patronNode* traversal;
+
+		//--------------------//
+		//Linked list traversal.
+		//--------------------//
+		traversal = head;
+		while (traversal != NULL)
+		{
+			traversal->patronSnapshot(buffer);
+			traversal = traversal->next;
+		}
+		buffer += "#checkpoint," + std::to_string(sequence) + '\n';
+	}
+
+	/*
+		function description:
+		Copies the list into a buffer as a binary snapshot. After the header ("LOANBIN1", the sequence number,
+		the number of records, and the length of the string pool) there is a fixed size record for each checked
+		out book, then the string pool, which has each author and patron name only once.
+
+		PARAM: string buffer, the snapshot is appended to this buffer.
+		PARAM: long long sequence, the sequence number of the last write ahead log record.
+	*/
+	void takeBinarySnapshot(std::string& buffer, long long sequence)
+	{
+		std::unordered_map<std::string, uint32_t> pooledNames;
+		std::string records, pool;
+		patronNode* traversal;
+		uint32_t recordCount = 0;
+
+		traversal = head;
+		while (traversal != NULL)
+		{
+			recordCount += traversal->appendBinaryLoans(records, pool, pooledNames);
+			traversal = traversal->next;
+		}
+
+		buffer += "LOANBIN1";
+		appendBinaryValue<long long>(buffer, sequence);
+		appendBinaryValue<uint32_t>(buffer, recordCount);
+		appendBinaryValue<uint32_t>(buffer, (uint32_t)pool.length());
+		buffer += records;
+		buffer += pool;
+	}
+
+	/*
+		function description:
+		Checks out every book in a binary snapshot written by takeBinarySnapshot.
+
+		PARAM: string contents, the contents of the snapshot file.
+		PARAM: long long sequence, set to the sequence number of the snapshot.
+		RETURN: bool, false if the contents aren't a complete binary snapshot, in which case nothing is loaded.
+	*/
+	bool loadBinarySnapshot(const std::string& contents, long long& sequence)
+	{
+		const size_t headerLength = 8 + sizeof(long long) + (2 * sizeof(uint32_t));
+		const size_t recordLength = 6 * sizeof(uint32_t);
+		std::string title, author, patronName;
+		size_t position = 8;
+		size_t poolStart;
+		uint32_t recordCount;
+		uint32_t poolLength;
+		long long snapshotSequence;
+
+		if ((contents.length() < headerLength) || (contents.compare(0, 8, "LOANBIN1") != 0))
+			return false;
+		snapshotSequence = readBinaryValue<long long>(contents, position);
+		recordCount = readBinaryValue<uint32_t>(contents, position);
+		poolLength = readBinaryValue<uint32_t>(contents, position);
+		poolStart = headerLength + ((size_t)recordCount * recordLength);
+		if (poolStart + poolLength != contents.length())
+			return false;
+
+		//Every string is checked to be inside the pool before anything is loaded.
+		for (uint32_t i = 0; i < recordCount * 3; i++)
+		{
+			if (!readBinaryString(contents, position, poolStart, NULL))
+				return false;
+		}
+
+		position = headerLength;
+		for (uint32_t i = 0; i < recordCount; i++)
+		{
+			readBinaryString(contents, position, poolStart, &title);
+			readBinaryString(contents, position, poolStart, &author);
+			readBinaryString(contents, position, poolStart, &patronName);
+			checkOut(title, author, patronName);
+		}
+		sequence = snapshotSequence;
+		return true;
+	}
+
+	std::shared_timed_mutex& getMutex(void)
+	{
+		return loanMutex;
+	}
+
+	void setDirtyFlag(bool flag)
+	{
+		dirtyFlag = flag;
+	}
+
+	long long getCheckpointSequence(void)
+	{
+		return checkpointSequence;
+	}
+	void setCheckpointSequence(long long sequence)
+	{
+		checkpointSequence = sequence;
+	}
+
+	const std::string& getWritebackFilename(void)
+	{
+		return writebackFilename;
+	}
+	std::string getSnapshotFilename(void)
+	{
+		return s_binarySnapshotFlag ? binarySnapshotFilename(writebackFilename) : writebackFilename;
+	}
+
+	bool getCsvOutdatedFlag(void)
+	{
+		return csvOutdatedFlag;
+	}
+	void setCsvOutdatedFlag(bool flag)
+	{
+		csvOutdatedFlag = flag;
+	}
+
+	bool getCsvKeptFlag(void)
+	{
+		return csvKeptFlag;
+	}
+	void setCsvKeptFlag(bool flag)
+	{
+		csvKeptFlag = flag;
+	}
+
+	/*
+		function description:
+		deallocates the patron list. Each patron's book tree is deallocated along with its own slab,
+		then the patron nodes are freed along with the slab of the list.
+	*/
+	~patronList()
+	{
+		patronNode* traversal;
+		patronNode* next;
+
+		traversal = head;
+		while (traversal != NULL)
+		{
+			next = traversal->next;
+			slab.release(traversal);
+			traversal = next;
+		}
+
+		head = NULL;
+		tail = NULL;
+	}
+};
+
+/*
+	class description:
+	The availabilityIndex is a catalog wide index from the title and author of a book to the
+	branches that have copies of it on the shelf, and how many copies each of those branches has.
+	It is kept up to date by the Library class whenever books are shelved or checked out, so
+	checking a book out only takes one lookup no matter how many branches there are.
+*/
+class availabilityIndex
+{
+private:
+	struct branchCopies
+	{
+		int branch;
+		int copies;
+	};
+
+	//Only branches with at least one copy are kept in the list for a book.
+	std::unordered_map<bookKey, std::vector<branchCopies>, bookKeyHash> index;
+
+	//The index is shared by every branch, so it is locked for writing while a copy is counted
+	//or removed (the branch is already locked by then) and for reading while a branch is found.
+	std::shared_timed_mutex indexMutex;
+
+public:
+	void addCopy(const std::string& title, const std::string& author, int branch)
+	{
+		addCopy(bookKey::intern(title, author), branch);
+	}
+	void addCopy(const bookKey& key, int branch)
+	{
+		std::lock_guard<std::shared_timed_mutex> lock(indexMutex);
+		std::vector<branchCopies>& branches = index[key];
+
+		for (int i = 0; i < (int)branches.size(); i++)
+		{
+			if (branches[i].branch == branch)
+			{
+				branches[i].copies++;
+				return;
+			}
+		}
+		branches.push_back(branchCopies{ branch, 1 });
+	}
+
+	void removeCopy(const std::string& title, const std::string& author, int branch)
+	{
+		std::unordered_map<bookKey, std::vector<branchCopies>, bookKeyHash>::iterator match;
+		bookKey key;
+
+		if (!bookKey::find(title, author, key))
+			return;
+		std::lock_guard<std::shared_timed_mutex> lock(indexMutex);
+		match = index.find(key);
+		if (match == index.end())
+			return;
+
+		std::vector<branchCopies>& branches = match->second;
+		for (int i = 0; i < (int)branches.size(); i++)
+		{
+			if (branches[i].branch == branch)
+			{
+				branches[i].copies--;
+				if (branches[i].copies == 0)
+					branches.erase(branches.begin() + i);
+				break;
+			}
+		}
+		if (branches.empty())
+			index.erase(match);
+	}
+
+	/*
+		function description:
+		Finds a branch that has a copy of a book on the shelf. The preferred branch is chosen if it
+		has a copy, otherwise the branch with the lowest branchId that has a copy is chosen.
+
+		PARAM: string title, the title of the book.
+		PARAM: string author, the author of the book.
+		PARAM: int preferredBranch, the branch to use if it has a copy (-1 for no preference).
+		RETURN: int, the branchId of the chosen branch, or -1 if no branch has a copy.
+	*/
+	int findBranch(const std::string& title, const std::string& author, int preferredBranch = -1)
+	{
+		std::unordered_map<bookKey, std::vector<branchCopies>, bookKeyHash>::iterator match;
+		int chosen = -1;
+		bookKey key;
+
+		if (!bookKey::find(title, author, key))
+			return -1;
+		std::shared_lock<std::shared_timed_mutex> lock(indexMutex);
+		match = index.find(key);
+		if (match == index.end())
+			return -1;
+
+		std::vector<branchCopies>& branches = match->second;
+		for (int i = 0; i < (int)branches.size(); i++)
+		{
+			if (branches[i].branch == preferredBranch)
+				return preferredBranch;
+			if ((chosen == -1) || (branches[i].branch < chosen))
+				chosen = branches[i].branch;
+		}
+		return chosen;
+	}
+};
+
+static availabilityIndex s_availabilityObject;
+
+/*
+	class description:
+	Library class inherits the booktree class, and also controls a linked list
+	of book nodes by using their rightLeafTitle bookNode* as 'next node'.
+*/
+class Library : public bookTree
+{
+private:
+	std::string name;
+	std::string writebackFilename;
+	int branch;
+	bookNode* shelvingBacklogHead;
+	bookNode* shelvingBacklogTail;
+	int linkedListLength;
+
+	//When the first book in the backlog was returned, for the shelving time limit.
+	std::chrono::steady_clock::time_point backlogStartTime;
+
+	//The number of copies of each book in the backlog, so a book can be found on the cart before it is shelved.
+	std::unordered_map<bookKey, int, bookKeyHash> cartIndex;
+
+	//Counts of the books checked out from and returned to the branch since the program started.
+	long long checkoutCount = 0;
+	long long returnCount = 0;
+
+	//Set when returned books are shelved, until the user has been told.
+	std::atomic<bool> shelvedFlag{ false };
+
+	//Set whenever a book is shelved, checked out, or returned, so the library is only written back when it has changed.
+	bool dirtyFlag = false;
+
+	//The sequence number of the last write ahead log record included in the .csv file.
+	long long checkpointSequence = 0;
+
+	//Set when a binary snapshot is written back, until the .csv file is exported again.
+	bool csvOutdatedFlag = false;
+
+	//Set when the .csv file was changed outside the program but wasn't read, so it is never overwritten.
+	bool csvKeptFlag = false;
+
+	//Locked for reading while the catalogue is printed or copied, and for writing while books are shelved or checked out.
+	std::shared_timed_mutex libraryMutex;
+public:
+	Library(std::string Name, std::string WritebackFilename, int Branch)
+	{
+		name = Name;
+		writebackFilename = WritebackFilename;
+		branch = Branch;
+		shelvingBacklogHead = NULL;
+		shelvingBacklogTail = NULL;
+		linkedListLength = 0;
+	}
+
+	/*
+		function description:
+		Adds a book to the trees of bookTree, and counts the copy in the availability index.
+	*/
+	void addBook(std::string title, std::string author)
+	{
+		bookTree::addBook(title, author);
+		s_availabilityObject.addCopy(title, author, branch);
+		dirtyFlag = true;
+	}
+
+	/*
+		function description:
+		Adds the books read from the .csv file to the trees of bookTree with one bulk build. The copies aren't
+		counted in the availability index here, since the branches are loaded at the same time and the index
+		is shared, so initializeLibraries counts them with countCopies once every branch has been loaded.
+
+		PARAM: vector<string> fields, the title and author of each book, one after the other.
+	*/
+	void loadBooks(const std::vector<std::string>& fields)
+	{
+		bulkLoad(fields);
+	}
+
+	/*
+		function description:
+		Deletes a book from the trees of bookTree, and removes the copy from the availability index.
+	*/
+	bool deleteBook(std::string title, std::string author)
+	{
+		if (!bookTree::deleteBook(title, author))
+			return false;
+		s_availabilityObject.removeCopy(title, author, branch);
+		checkoutCount++;
+		dirtyFlag = true;
+		return true;
+	}
+
+	/*
+		function description:
+		Returns a book. The book is added to the end of a linked list of book nodes (the cart), where it waits
+		until shelveBacklog is called, and it is counted in the cart index so it can be found in the meantime.
+
+		PARAM: string title, title of the book being returned.
+		PARAM: string author, author of the book being returned.
+	*/
+	void bookReturned(std::string title, std::string author)
+	{
+		bookNode* newnode;
+		newnode = slab.allocate();
+
+		newnode->assign(title, author);
+		cartIndex[newnode->getBookKey()]++;
+		returnCount++;
+		dirtyFlag = true;
+
+		//Using rightLeafTitle pointer like a next pointer so that the same class can
+		//be used in to form a tree and a linked list. The tail pointer saves walking the list.
+		if (shelvingBacklogHead == NULL)
+		{
+			shelvingBacklogHead = newnode;
+			backlogStartTime = std::chrono::steady_clock::now();
+		}
+		else
+			shelvingBacklogTail->rightLeafTitle = newnode;
+		shelvingBacklogTail = newnode;
+		linkedListLength++;
+	}
+
+	/*
+		function description:
+		Checks whether the backlog should be shelved, because s_shelvingBatchSize books have been returned
+		or the first of them has been waiting for s_shelvingBatchSeconds.
+	*/
+	bool shelvingDue(void)
+	{
+		if (linkedListLength == 0)
+			return false;
+		return (linkedListLength >= s_shelvingBatchSize) ||
+			(std::chrono::steady_clock::now() - backlogStartTime >= std::chrono::seconds(s_shelvingBatchSeconds));
+	}
+
+	/*
+		function description:
+		Shelves every book in the backlog as one batch. The nodes of the backlog are moved into the trees
+		with mergeNodes rather than being copied, then counted in the availability index.
+	*/
+	void shelveBacklog(void)
+	{
+		std::vector<bookNode*> batch;
+		bookNode* traverse;
+
+		if (shelvingBacklogHead == NULL)
+			return;
+
+		batch.reserve(linkedListLength);
+		for (traverse = shelvingBacklogHead; traverse != NULL; traverse = traverse->rightLeafTitle)
+			batch.push_back(traverse);
+		mergeNodes(batch);
+		for (size_t i = 0; i < batch.size(); i++)
+			s_availabilityObject.addCopy(batch[i]->getBookKey(), branch);
+
+		shelvingBacklogHead = NULL;
+		shelvingBacklogTail = NULL;
+		linkedListLength = 0;
+		cartIndex.clear();
+		dirtyFlag = true;
+
+		//So that the user can be informed that books were shelved and at which library.
+		shelvedFlag = true;
+	}
+
+	/*
+		function description:
+		Counts the copies of a book that have been returned to the branch but not shelved yet.
+		The library must be locked for reading.
+
+		RETURN: int, the number of copies on the cart.
+	*/
+	int copiesOnCart(const std::string& title, const std::string& author)
+	{
+		std::unordered_map<bookKey, int, bookKeyHash>::iterator match;
+		bookKey key;
+
+		if (!bookKey::find(title, author, key))
+			return 0;
+		match = cartIndex.find(key);
+		return (match == cartIndex.end()) ? 0 : match->second;
+	}
+
+	/*
+		function description:
+		If the library has changed since it was last written back, copies it into a buffer as a binary snapshot
+		or as the lines of its .csv file, depending on s_binarySnapshotFlag, and clears the dirty flag.
+
+		PARAM: string buffer, the snapshot is appended to this buffer.
+		PARAM: long long sequence, the sequence number of the last write ahead log record.
+		RETURN: bool, true if the library had changed and was copied into the buffer.
+	*/
+	bool takeSnapshot(std::string& buffer, long long sequence)
+	{
+		if (!dirtyFlag)
+			return false;
+
+		if (s_binarySnapshotFlag)
+		{
+			takeBinarySnapshot(buffer, sequence);
+			csvOutdatedFlag = true;
+		}
+		else
+			takeCsvSnapshot(buffer, sequence);
+
+		checkpointSequence = sequence;
+		dirtyFlag = false;
+		return true;
+	}
+
+	/*
+		function description:
+		Copies the library into a buffer as the lines of its .csv file. The backlog of books is included even
+		if there aren't five, so they are shelved when the file is read back in. The last line records the
+		sequence number of the last write ahead log record that the copy includes.
+
+		PARAM: string buffer, the .csv lines are appended to this buffer.
+		PARAM: long long sequence, the sequence number of the last write ahead log record.
+	*/
+	void takeCsvSnapshot(std::string& buffer, long long sequence)
+	{
+		bookNode* traverse;
+
+		snapshot(buffer);
+
+		traverse = shelvingBacklogHead;
+		while (traverse != NULL)
+		{
+			appendCsvField(buffer, traverse->getTitle());
+			buffer += ',';
+			appendCsvField(buffer, traverse->getAuthorName());
+			buffer += '\n';
+			traverse = traverse->rightLeafTitle;
+		}
+		buffer += "#checkpoint," + std::to_string(sequence) + '\n';
+	}
+
+	/*
+		function description:
+		Copies the library into a buffer as a binary snapshot. After the header ("LIBBIN01", the sequence
+		number, the number of books, the number of books in the backlog, and the length of the string pool)
+		there is a fixed size record for each book in order of title, then the backlog, then the title and
+		author order arrays, then the string pool, which has each author only once. Each record has 32 bit
+		offsets and lengths of its title and author in the string pool.
+
+		PARAM: string buffer, the snapshot is appended to this buffer.
+		PARAM: long long sequence, the sequence number of the last write ahead log record.
+	*/
+	void takeBinarySnapshot(std::string& buffer, long long sequence)
+	{
+		std::unordered_map<std::string, uint32_t> pooledAuthors;
+		std::string records, orders, pool;
+		bookNode* traverse;
+		uint32_t bookCount;
+		uint32_t backlogCount = 0;
+
+		bookCount = appendBinaryBooks(records, orders, pool, pooledAuthors);
+
+		traverse = shelvingBacklogHead;
+		while (traverse != NULL)
+		{
+			appendBinaryString(records, pool, traverse->getTitle(), NULL);
+			appendBinaryString(records, pool, traverse->getAuthorName(), &pooledAuthors);
+			backlogCount++;
+			traverse = traverse->rightLeafTitle;
+		}
+
+		buffer += "LIBBIN01";
+		appendBinaryValue<long long>(buffer, sequence);
+		appendBinaryValue<uint32_t>(buffer, bookCount);
+		appendBinaryValue<uint32_t>(buffer, backlogCount);
+		appendBinaryValue<uint32_t>(buffer, (uint32_t)pool.length());
+		buffer += records;
+		buffer += orders;
+		buffer += pool;
+	}
+
+	/*
+		function description:
+		Loads an empty library from a binary snapshot written by takeBinarySnapshot. The trees are linked
+		straight from the order arrays, so nothing is parsed or sorted. The books in the backlog are shelved,
+		the same as when a .csv file is loaded. The copies aren't counted in the availability index here,
+		initializeLibraries counts them with countCopies.
+
+		PARAM: string contents, the contents of the snapshot file.
+		PARAM: long long sequence, set to the sequence number of the snapshot.
+		RETURN: bool, false if the contents aren't a complete binary snapshot, in which case nothing is loaded.
+	*/
+	bool loadBinarySnapshot(const std::string& contents, long long& sequence)
+	{
+		const size_t headerLength = 8 + sizeof(long long) + (3 * sizeof(uint32_t));
+		const size_t recordLength = 4 * sizeof(uint32_t);
+		std::vector<bookNode*> nodes;
+		std::vector<uint32_t> titleOrder, authorOrder;
+		std::string title, author;
+		size_t position = 8;
+		size_t ordersStart, poolStart;
+		uint32_t bookCount, backlogCount, poolLength;
+		long long snapshotSequence;
+
+		if ((titleRoot != NULL) || (contents.length() < headerLength) || (contents.compare(0, 8, "LIBBIN01") != 0))
+			return false;
+		snapshotSequence = readBinaryValue<long long>(contents, position);
+		bookCount = readBinaryValue<uint32_t>(contents, position);
+		backlogCount = readBinaryValue<uint32_t>(contents, position);
+		poolLength = readBinaryValue<uint32_t>(contents, position);
+		ordersStart = headerLength + (((size_t)bookCount + backlogCount) * recordLength);
+		poolStart = ordersStart + ((size_t)bookCount * 2 * sizeof(uint32_t));
+		if (poolStart + poolLength != contents.length())
+			return false;
+
+		//Every string and order entry is checked before anything is loaded.
+		for (size_t i = 0; i < ((size_t)bookCount + backlogCount) * 2; i++)
+		{
+			if (!readBinaryString(contents, position, poolStart, NULL))
+				return false;
+		}
+		titleOrder.resize(bookCount);
+		authorOrder.resize(bookCount);
+		if (bookCount != 0)
+		{
+			memcpy(&titleOrder[0], contents.data() + ordersStart, bookCount * sizeof(uint32_t));
+			memcpy(&authorOrder[0], contents.data() + ordersStart + (bookCount * sizeof(uint32_t)), bookCount * sizeof(uint32_t));
+		}
+		for (uint32_t i = 0; i < bookCount; i++)
+		{
+			if (((titleOrder[i] & ~s_copyOfPreviousBit) >= bookCount) || ((authorOrder[i] & ~s_copyOfPreviousBit) >= bookCount))
+				return false;
+		}
+
+		position = headerLength;
+		nodes.reserve(bookCount);
+		bookIndex.reserve(bookCount);
+		for (uint32_t i = 0; i < bookCount; i++)
+		{
+			readBinaryString(contents, position, poolStart, &title);
+			readBinaryString(contents, position, poolStart, &author);
+			nodes.push_back(slab.allocate());
+			nodes.back()->assign(title, author);
+			bookIndex.insert(std::make_pair(nodes.back()->getBookKey(), nodes.back()));
+		}
+		buildFromOrders(nodes, titleOrder, authorOrder);
+
+		nodes.clear();
+		for (uint32_t i = 0; i < backlogCount; i++)
+		{
+			readBinaryString(contents, position, poolStart, &title);
+			readBinaryString(contents, position, poolStart, &author);
+			nodes.push_back(slab.allocate());
+			nodes.back()->assign(title, author);
+		}
+		mergeNodes(nodes);
+		sequence = snapshotSequence;
+		return true;
+	}
+
+	/*
+		function description:
+		Counts every book on the shelves of the library in the availability index.
+	*/
+	void countCopies(void)
+	{
+		std::vector<bookNode*> nodes;
+
+		collectInOrder(nodes, TITLE_TREE);
+		for (size_t i = 0; i < nodes.size(); i++)
+			s_availabilityObject.addCopy(nodes[i]->getBookKey(), branch);
+	}
+
+	std::shared_timed_mutex& getMutex(void)
+	{
+		return libraryMutex;
+	}
+
+	const std::string& getName(void)
+	{
+		return name;
+	}
+
+	/*
+		function description:
+		Clears the flag that is set when returned books are shelved.
+
+		RETURN: bool, true if books have been shelved since the last time the flag was cleared.
+	*/
+	bool takeShelvedFlag(void)
+	{
+		return shelvedFlag.exchange(false);
+	}
+
+	/*
+		function description:
+		Prints the number of books at the branch, how many have been checked out and returned since the
+		program started, and the memory the branch uses. The library must be locked for reading.
+	*/
+	void printStats(void)
+	{
+		std::cout << "          " << name << ": " << bookIndex.size() << " books on the shelves, " << linkedListLength
+			<< " waiting to be shelved, " << checkoutCount << " checked out, " << returnCount << " returned, "
+			<< memoryUsage() << " bytes" << std::endl;
+	}
+
+	/*
+		function description:
+		Prints the catalogue without locking the library, so browsing never waits on checkouts, returns, or
+		writeback. If the library has changed, a new version of the catalogue is published first, but only
+		if the library can be locked for reading right away. Otherwise the last version is printed, which is
+		the catalogue from before the change that is being made. A single page of a library that has changed is
+		printed straight from the trees instead, since seeking to the page is O(log n) and publishing is O(n).
+
+		PARAM: string select: the selection for which alphabetical order (must be 'title' or 'author')
+		PARAM: string startKey: the title or author to start printing from, the default prints every book.
+		PARAM: int page: the page to print, starting from 1.
+		PARAM: int pageSize: the number of books on each page, the default prints every book on one page.
+	*/
+	void printList(std::string select, std::string startKey = "", int page = 1, int pageSize = 0)
+	{
+		std::string pageText;
+
+		if ((pageSize > 0) && catalogueDirtyFlag && libraryMutex.try_lock_shared())
+		{
+			appendTreePage(pageText, select, startKey, page, pageSize);
+			libraryMutex.unlock_shared();
+			std::cout << pageText << std::flush;
+			return;
+		}
+		printCatalogue(*getCatalogue(), select, startKey, page, pageSize);
+	}
+
+	/*
+		function description:
+		Finds the books whose title or author starts with a prefix, in the same way the catalogue is printed: from
+		the last published version without locking the library, or straight from the trees if the library has
+		changed and can be locked for reading right away.
+
+		PARAM: string prefix, the start of the title or author being searched for.
+		PARAM: treeSelect tree, whether the titles or the authors are searched.
+		PARAM: int limit, the most books to find.
+		PARAM: vector<prefixMatch> matches, the books found are appended in order.
+	*/
+	void searchPrefix(const std::string& prefix, treeSelect tree, int limit, std::vector<prefixMatch>& matches)
+	{
+		std::shared_ptr<const catalogueSnapshot> version;
+
+		if (catalogueDirtyFlag && libraryMutex.try_lock_shared())
+		{
+			findPrefix(prefix, tree, limit, matches);
+			libraryMutex.unlock_shared();
+			return;
+		}
+		version = getCatalogue();
+		if (tree == TITLE_TREE)
+			version->titleCatalogue.findPrefix(prefix, limit, matches);
+		else
+			version->authorCatalogue.findPrefix(prefix, limit, matches);
+	}
+
+	/*
+		function description:
+		Returns the latest published version of the catalogue, publishing a new version first if the
+		library has changed and it can be locked for reading right away.
+	*/
+	std::shared_ptr<const catalogueSnapshot> getCatalogue(void)
+	{
+		std::shared_ptr<const catalogueSnapshot> version;
+
+		if (catalogueDirtyFlag && libraryMutex.try_lock_shared())
+		{
+			version = refreshCatalogue(false);
+			libraryMutex.unlock_shared();
+		}
+		else
+			version = std::atomic_load(&catalogue);
+
+		//Until the first version is published there is nothing to print, so the first reader has to wait for it.
+		if (!version)
+		{
+			libraryMutex.lock_shared();
+			version = refreshCatalogue(true);
+			libraryMutex.unlock_shared();
+		}
+		return version;
+	}
+
+	void setDirtyFlag(bool flag)
+	{
+		dirtyFlag = flag;
+	}
+
+	long long getCheckpointSequence(void)
+	{
+		return checkpointSequence;
+	}
+	void setCheckpointSequence(long long sequence)
+	{
+		checkpointSequence = sequence;
+	}
+
+	const std::string& getWritebackFilename(void)
+	{
+		return writebackFilename;
+	}
+	std::string getSnapshotFilename(void)
+	{
+		return s_binarySnapshotFlag ? binarySnapshotFilename(writebackFilename) : writebackFilename;
+	}
+
+	bool getCsvOutdatedFlag(void)
+	{
+		return csvOutdatedFlag;
+	}
+	void setCsvOutdatedFlag(bool flag)
+	{
+		csvOutdatedFlag = flag;
+	}
+
+	bool getCsvKeptFlag(void)
+	{
+		return csvKeptFlag;
+	}
+	void setCsvKeptFlag(bool flag)
+	{
+		csvKeptFlag = flag;
+	}
+};
+
+/*
+	class description:
+	The csvReader splits the contents of a .csv file into records and fields. The end of each
+	line and each comma are found with memchr rather than a character at a time, and the strings
+	for the fields are reused from one record to the next so that reading a record doesn't
+	allocate any memory once the strings are long enough.
+
+	important info:
+	 - A field starting with a quote runs until the next quote that isn't doubled, and can contain
+	 commas, newlines, and doubled quotes, which are read as one quote. appendCsvField writes fields
+	 this way when they need it.
+	 - A carriage return at the end of a line is ignored, so files saved on Windows can be read.
+*/
+class csvReader
+{
+private:
+	const char* start;
+	const char* position;
+	const char* end;
+	const char* lineEnd;
+	const char* recordStart;
+	std::vector<std::string> fields;
+	int fieldCount = 0;
+	bool firstFieldQuoted = false;
+
+	/*
+		function description:
+		Finds the end of the line starting at the current position.
+	*/
+	void findLineEnd(void)
+	{
+		lineEnd = (const char*)memchr(position, '\n', end - position);
+		if (lineEnd == NULL)
+			lineEnd = end;
+	}
+
+	/*
+		function description:
+		Reads the quoted field starting at the current position.
+
+		PARAM: string field, set to the field without the quotes.
+	*/
+	void readQuotedField(std::string& field)
+	{
+		const char* quote;
+
+		position++;
+		while (position < end)
+		{
+			quote = (const char*)memchr(position, '"', end - position);
+			if (quote == NULL)
+				quote = end;
+			field.append(position, quote - position);
+			position = quote + 1;
+
+			//A doubled quote is part of the field, any other quote ends it.
+			if ((position < end) && (*position == '"'))
+			{
+				field += '"';
+				position++;
+			}
+			else
+				break;
+		}
+		if (position > end)
+			position = end;
+
+		//The field may have had newlines in it, so the line carries on past the old line end.
+		findLineEnd();
+		position = (const char*)memchr(position, ',', lineEnd - position);
+		if (position == NULL)
+			position = lineEnd;
+	}
+
+public:
+	csvReader(const std::string& contents)
+	{
+		start = position = recordStart = contents.data();
+		end = contents.data() + contents.length();
+		lineEnd = position;
+	}
+
+	csvReader(const char* data, size_t length)
+	{
+		start = position = recordStart = data;
+		end = data + length;
+		lineEnd = position;
+	}
+
+	/*
+		function description:
+		Reads the next record into the fields, skipping empty lines.
+
+		RETURN: bool, false if there are no records left.
+	*/
+	bool nextRecord(void)
+	{
+		const char* comma;
+
+		while ((position < end) && ((*position == '\n') || (*position == '\r')))
+			position++;
+		if (position >= end)
+			return false;
+
+		recordStart = position;
+		firstFieldQuoted = (*position == '"');
+		findLineEnd();
+		fieldCount = 0;
+		while (true)
+		{
+			if (fieldCount == (int)fields.size())
+				fields.emplace_back();
+			fields[fieldCount].clear();
+
+			if (*position == '"')
+				readQuotedField(fields[fieldCount]);
+			else
+			{
+				comma = (const char*)memchr(position, ',', lineEnd - position);
+				if (comma == NULL)
+					comma = lineEnd;
+				fields[fieldCount].assign(position, comma - position);
+				position = comma;
+			}
+			fieldCount++;
+
+			if (position >= lineEnd)
+				break;
+			position++;
+		}
+
+		//Removes the carriage return of a Windows line ending.
+		if (!fields[fieldCount - 1].empty() && (fields[fieldCount - 1].back() == '\r'))
+			fields[fieldCount - 1].pop_back();
+		position = lineEnd;
+		return true;
+	}
+
+	/*
+		function description:
+		Returns a field of the current record, or an empty string if the record doesn't have that many fields.
+	*/
+	const std::string& field(int i)
+	{
+		static const std::string empty;
+
+		if (i >= fieldCount)
+			return empty;
+		return fields[i];
+	}
+
+	int getFieldCount(void)
+	{
+		return fieldCount;
+	}
+
+	/*
+		function description:
+		Returns whether the current record ended with a newline, rather than running into the end of the contents.
+	*/
+	bool lineComplete(void)
+	{
+		return lineEnd < end;
+	}
+
+	/*
+		function description:
+		Returns where the current record starts, and where the record after it starts, as offsets into the contents.
+	*/
+	size_t recordOffset(void)
+	{
+		return recordStart - start;
+	}
+	size_t nextOffset(void)
+	{
+		return ((lineEnd < end) ? lineEnd + 1 : end) - start;
+	}
+
+	/*
+		function description:
+		Returns whether the current record is a line of information about the file rather than a record,
+		which starts with an unquoted '#'. appendCsvField quotes every field starting with '#'.
+	*/
+	bool metadataLine(void)
+	{
+		return (fieldCount > 0) && !firstFieldQuoted && (fields[0].compare(0, 1, "#") == 0);
+	}
+
+	/*
+		function description:
+		Checks if the current record is the line written at the end of a .csv file by persistChanges,
+		which has the sequence number of the last write ahead log record included in the file. The line
+		is only a checkpoint line if "#checkpoint" isn't quoted and the sequence number is a number, and
+		appendCsvField quotes every field starting with '#', so a book with the title "#checkpoint" is
+		still read as a book. Rows added to the end of the file by hand can follow the checkpoint line.
+
+		PARAM: long long sequence, set to the sequence number if the record is a checkpoint line.
+		RETURN: bool, true if the record is a checkpoint line.
+	*/
+	bool readCheckpoint(long long& sequence)
+	{
+		long long value;
+
+		if ((fieldCount != 2) || firstFieldQuoted || (fields[0] != "#checkpoint") || !parseInteger(fields[1], value))
+			return false;
+
+		sequence = value;
+		return true;
+	}
+
+	/*
+		function description:
+		Checks if the current record is a checksum line written by writeSnapshotFile. The checksum line is
+		normally removed by readSnapshotFile, but is left in the middle of the file when rows are added to
+		the end of the file by hand, and must not be read as a book.
+
+		RETURN: bool, true if the record is a checksum line.
+	*/
+	bool checksumLine(void)
+	{
+		if ((fieldCount != 2) || firstFieldQuoted || (fields[0] != "#checksum") || (fields[1].length() != 16))
+			return false;
+
+		for (size_t i = 0; i < fields[1].length(); i++)
+		{
+			if (!isxdigit((unsigned char)fields[1][i]))
+				return false;
+		}
+		return true;
+	}
+};
+
+/*
+	class description:
+	The writeAheadLog is an append only file with one line for every checkout, check in, and returned book,
+	so that changes made since the .csv files were last written back aren't lost if the program stops.
+	Each line starts with a sequence number, and each .csv file ends with the sequence number of the last
+	record it includes, so when the log is replayed at startup each record is only applied to the files
+	that don't already include it.
+
+	important info:
+	 - Records are appended to a buffer by append, and a separate thread writes the buffer to the file.
+	 While one batch is being written and synced, the next batch accumulates in the buffer, so many
+	 records share the cost of one sync (group commit).
+	 - append is called while the objects being changed are locked so that the records are in the same order
+	 as the changes. waitForCommit should be called after unlocking, so users aren't kept waiting on a sync.
+	 - Once every changed .csv file has been written back, the records they include are removed from
+	 the log with truncateThrough.
+*/
+class writeAheadLog
+{
+private:
+	std::mutex logMutex;
+	std::condition_variable logCondition;
+	std::thread flushThread;
+	std::string filename;
+	FILE* file = NULL;
+
+	std::string pending;
+	long long lastSequence = 0;
+	long long committedSequence = 0;
+	bool flushingFlag = false;
+	bool stopFlag = false;
+
+	//Set while truncateThrough copies the log, so the flush thread holds the records in the buffer rather than
+	//writing them to the old file. Records can still be appended, they are written to the new file once it is in place.
+	bool truncatingFlag = false;
+
+	//Set once a batch can't be written or synced (such as when the disk is full). The records from then on aren't
+	//committed, and are only saved by the next writeback, since the objects they changed are marked as changed.
+	bool failedFlag = false;
+
+	/*
+		function description:
+		Run by the flush thread, writes and syncs the buffered records one batch at a time. A batch is only
+		committed once it has been written and synced, otherwise the log is marked as failed.
+	*/
+	void flushLoop(void)
+	{
+		std::string batch;
+		long long batchSequence;
+		bool written;
+		std::unique_lock<std::mutex> lock(logMutex);
+
+		while (true)
+		{
+			while (truncatingFlag || (pending.empty() && !stopFlag))
+				logCondition.wait(lock);
+			if (pending.empty() && stopFlag)
+				return;
+
+			batch.swap(pending);
+			batchSequence = lastSequence;
+			flushingFlag = true;
+			written = !failedFlag && (file != NULL);
+			lock.unlock();
+
+			//After a failure nothing more is written, since the log would have a gap where the failed batch was.
+			written = written && (fwrite(batch.data(), 1, batch.length(), file) == batch.length());
+			written = written && (fflush(file) == 0) && syncFile(file);
+			batch.clear();
+
+			lock.lock();
+			flushingFlag = false;
+			if (written)
+				committedSequence = batchSequence;
+			else
+				failedFlag = true;
+			logCondition.notify_all();
+		}
+	}
+
+public:
+	/*
+		function description:
+		Checks that a record read from the log is complete: it ends with a newline, has the number of fields its
+		type needs, and its numbers can be read. If the program stops part way through a flush, the log can end
+		in a partial record, which must be skipped rather than replayed.
+
+		PARAM: csvReader record, the record being checked.
+		PARAM: long long sequence, set to the sequence number of the record.
+		RETURN: bool, true if the record can be replayed.
+	*/
+	static bool validRecord(csvReader& record, long long& sequence)
+	{
+		const std::string& type = record.field(1);
+		long long branch = 0;
+
+		if (!record.lineComplete() || !parseInteger(record.field(0), sequence))
+			return false;
+		if (type == "checkout")
+			return (record.getFieldCount() == 6) && parseInteger(record.field(5), branch) && (branch >= 0);
+		if (type == "checkin")
+			return record.getFieldCount() == 4;
+		if (type == "return")
+			return (record.getFieldCount() == 5) && parseInteger(record.field(4), branch) && (branch >= 0);
+		return false;
+	}
+
+	/*
+		function description:
+		Opens the log for appending and starts the flush thread.
+
+		PARAM: string Filename, the log file.
+		PARAM: long long sequence, the highest sequence number used so far.
+		RETURN: bool, true if the log was opened.
+	*/
+	bool open(std::string Filename, long long sequence)
+	{
+		filename = Filename;
+		//The sequence numbers carry on even if the log can't be opened, since they are also the checkpoints of the .csv files.
+		lastSequence = sequence;
+		committedSequence = sequence;
+		file = fopen(filename.c_str(), "ab");
+		if (file == NULL)
+			return false;
+
+		stopFlag = false;
+		flushThread = std::thread(&writeAheadLog::flushLoop, this);
+		return true;
+	}
+
+	/*
+		function description:
+		Buffers a record to be written to the log. If the log isn't open or has failed, nothing would write the
+		buffer, so the record only gets a sequence number, and the change is saved on the next writeback.
+
+		PARAM: string record, the comma separated fields of the record.
+		RETURN: long long, the sequence number given to the record.
+	*/
+	long long append(const std::string& record)
+	{
+		std::lock_guard<std::mutex> lock(logMutex);
+
+		lastSequence++;
+		if ((file == NULL) || failedFlag)
+			return lastSequence;
+		pending += std::to_string(lastSequence) + ',' + record + '\n';
+		logCondition.notify_all();
+		return lastSequence;
+	}
+
+	/*
+		function description:
+		Waits until a record has been written to the log and synced.
+
+		PARAM: long long sequence, the sequence number returned by append.
+		RETURN: bool, false if the record couldn't be written to the log, so it is only saved on the next writeback.
+	*/
+	bool waitForCommit(long long sequence)
+	{
+		std::unique_lock<std::mutex> lock(logMutex);
+
+		while ((committedSequence < sequence) && !failedFlag && (file != NULL))
+			logCondition.wait(lock);
+		return committedSequence >= sequence;
+	}
+
+	long long getLastSequence(void)
+	{
+		std::lock_guard<std::mutex> lock(logMutex);
+		return lastSequence;
+	}
+
+	/*
+		function description:
+		Removes every record up to and including a sequence number from the log, once the .csv files
+		include them. The records after it are copied into a new file, which is synced before it is renamed
+		over the log, since they have already been reported as committed. The copy is made without holding
+		the log's mutex, so checkouts and returns can still append records, and only the file is swapped
+		under the mutex.
+
+		PARAM: long long sequence, the sequence number of the last record to remove.
+	*/
+	void truncateThrough(long long sequence)
+	{
+		std::unique_lock<std::mutex> lock(logMutex);
+		std::string contents;
+		std::string kept;
+		std::string tempFilename = filename + ".tmp";
+		long long recordSequence;
+		FILE* newFile;
+		bool written;
+
+		if ((file == NULL) || truncatingFlag || failedFlag)
+			return;
+
+		//Waits for the flush thread to finish the batch it is writing, then holds back the next one.
+		while (flushingFlag)
+			logCondition.wait(lock);
+		truncatingFlag = true;
+		lock.unlock();
+
+		readSnapshotFile(filename, contents);
+		csvReader record(contents);
+		while (record.nextRecord())
+		{
+			if (writeAheadLog::validRecord(record, recordSequence) && (recordSequence > sequence))
+				kept.append(contents, record.recordOffset(), record.nextOffset() - record.recordOffset());
+		}
+
+		//The new file is kept open, so the flush thread carries on appending to it once it replaces the log.
+		newFile = fopen(tempFilename.c_str(), "wb");
+		written = (newFile != NULL) && (fwrite(kept.data(), 1, kept.length(), newFile) == kept.length());
+		written = written && (fflush(newFile) == 0) && syncFile(newFile);
+		if (!written && (newFile != NULL))
+			fclose(newFile);
+
+		lock.lock();
+		if (written)
+		{
+			//The old file is closed before the rename, since an open file can't be replaced on Windows.
+			fclose(file);
+			if (replaceFile(tempFilename, filename))
+				file = newFile;
+			else
+			{
+				fclose(newFile);
+				file = fopen(filename.c_str(), "ab");
+				written = false;
+			}
+		}
+		if (!written)
+			remove(tempFilename.c_str());
+		truncatingFlag = false;
+		logCondition.notify_all();
+	}
+
+	/*
+		function description:
+		Writes everything buffered, then stops the flush thread and closes the log.
+	*/
+	void close(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(logMutex);
+			stopFlag = true;
+			logCondition.notify_all();
+		}
+		if (flushThread.joinable())
+			flushThread.join();
+
+		std::lock_guard<std::mutex> lock(logMutex);
+		if (file != NULL)
+			fclose(file);
+		file = NULL;
+		logCondition.notify_all();
+	}
+
+	~writeAheadLog()
+	{
+		close();
+	}
+};
+
+/*
+	class description:
+	A branchWorker is a thread that makes every change to one Library. Commands (a checkout, a return, or a query)
+	are posted to its queue from any thread, and the result of each command is returned through a future. Since
+	each branch is only changed by its own worker, changes to different branches are made in parallel.
+
+	important info:
+	 - The worker swaps out every command in the queue at once and runs them as a batch, with the branch locked
+	 for writing once for the whole batch, so a burst of commands at one branch only takes the lock once.
+	 - Returned books are shelved by the worker after a batch, or when it wakes up and the shelving time limit
+	 has passed, so a return doesn't wait for shelving.
+	 - A command may lock the checked out books, since they come after the branch in the lock order, but it must
+	 not post to another branch and wait for the result.
+*/
+class branchWorker
+{
+private:
+	Library* library = NULL;
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::thread workerThread;
+	std::vector<std::function<void()>> queue;
+	bool stopFlag = false;
+
+	/*
+		function description:
+		Run by the worker thread, runs the commands in the queue one batch at a time until the worker is stopped.
+	*/
+	void workLoop(void)
+	{
+		std::vector<std::function<void()>> batch;
+		std::unique_lock<std::mutex> lock(queueMutex);
+
+		while (true)
+		{
+			//Only this thread changes the library, so it can check whether shelving is due without locking it.
+			while (queue.empty() && !stopFlag && !library->shelvingDue())
+				queueCondition.wait_for(lock, std::chrono::seconds(1));
+			if (queue.empty() && stopFlag)
+				return;
+
+			batch.swap(queue);
+			lock.unlock();
+
+			library->getMutex().lock();
+			for (size_t i = 0; i < batch.size(); i++)
+				batch[i]();
+			if (library->shelvingDue())
+				library->shelveBacklog();
+			library->getMutex().unlock();
+			batch.clear();
+
+			lock.lock();
+		}
+	}
+
+public:
+	/*
+		function description:
+		Starts the worker thread for a branch.
+
+		PARAM: Library* Branch, the branch the worker changes.
+	*/
+	void start(Library* Branch)
+	{
+		library = Branch;
+		stopFlag = false;
+		workerThread = std::thread(&branchWorker::workLoop, this);
+	}
+
+	/*
+		function description:
+		Posts a command to the queue. The command is called with the branch, which is locked for writing.
+
+		PARAM: command, a function object that takes a Library& and returns the result.
+		RETURN: a future for the result of the command.
+	*/
+	template <typename F>
+	std::future<typename std::result_of<F(Library&)>::type> post(F command)
+	{
+		typedef typename std::result_of<F(Library&)>::type result;
+		Library* branch = library;
+		std::shared_ptr<std::packaged_task<result()>> task;
+
+		task = std::make_shared<std::packaged_task<result()>>([command, branch]() mutable { return command(*branch); });
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			queue.push_back([task]() { (*task)(); });
+		}
+		queueCondition.notify_one();
+		return task->get_future();
+	}
+
+	/*
+		function description:
+		Runs the commands still in the queue, then stops the worker thread.
+	*/
+	void stop(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stopFlag = true;
+		}
+		queueCondition.notify_all();
+		if (workerThread.joinable())
+			workerThread.join();
+	}
+
+	~branchWorker()
+	{
+		stop();
+	}
+};
+
+/*
+Static variables, to be used by multiple threads.
+*/
+static std::string s_checkedOutFileName = "CheckedOut.csv";
+static std::string s_writeAheadLogFileName = "WriteAheadLog.csv";
+static std::string s_branchRegistryFileName = "Branches.txt";
+
+static writeAheadLog s_writeAheadLogObject;
+static patronList s_checkedOutObject(s_checkedOutFileName);
+
+//The library objects in order of branchId, so a branch found in the availability index or the write ahead log
+//can be accessed directly. The branches are read from the registry file by loadBranchRegistry.
+static std::vector<std::unique_ptr<Library>> s_branchObjects;
+
+//The branchId of each branch name, so a branch entered by the user is found without searching.
+static std::unordered_map<std::string, int> s_branchIds;
+
+//The worker thread of each branch, in order of branchId. They only run while users are making changes,
+//the branches are loaded and the write ahead log is replayed before they are started.
+static std::vector<std::unique_ptr<branchWorker>> s_branchWorkers;
+
+
+int main(void)
+{
+	//--------------------------------------------------------------------------------//
+	//Read the branches, initialize, start the branch workers and the writeback thread, then call the comand window control function.
+	//When control is passed back to main from the control window funciton, the static
+	//variable s_endProgram indicates to the writeback thread that it is time to stop.
+	//Changes in the write ahead log that the .csv files don't include yet are replayed
+	//and written back before starting.
+	//Anything changed since the last writeback is written back before exiting, and the
+	//.csv files are brought up to date with the binary snapshots.
+	//--------------------------------------------------------------------------------//
+	loadBranchRegistry();
+	initializeLibraries();
+	if (replayWriteAheadLog())
+		persistChanges();
+
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+		s_branchWorkers[i]->start(s_branchObjects[i].get());
+
+	std::thread t1(writebackChanges);
+	cmdWindowControl();
+	for (int i = 0; i < (int)s_branchWorkers.size(); i++)
+		s_branchWorkers[i]->stop();
+	s_endProgram = true;
+	t1.join();
+	persistChanges();
+	if (s_binarySnapshotFlag)
+		exportCsvFiles();
+	s_writeAheadLogObject.close();
+}
+
+/*
+Function that returns 1 if parameter a comes before b in alphabetical order,
+used to traverse binary search trees.
+*/
+bool alphabetical(const std::string& a, const std::string& b)
+{
+	return a < b;
+}
+
+/*
+Returns the number of bytes a string has allocated on the heap, which is zero
+if the string is short enough to be stored inside the string object itself.
+*/
+size_t stringHeapBytes(const std::string& str)
+{
+	if (str.capacity() < sizeof(std::string))
+		return 0;
+	return str.capacity() + 1;
+}
+
+/*
+Reads the branches from the registry file, one line for each branch with its name and the .csv file its
+books are kept in. Each branch's branchId is its place among the branches in the file, so new branches are added at the end to keep
+the branchIds in the write ahead log the same. If there is no registry file, the original three branches are used.
+
+The file can also have a line for each shelving setting, "#shelvingBatchSize,<books>" and
+"#shelvingBatchSeconds,<seconds>". A setting that is left out or isn't a positive number keeps its default.
+Any other line starting with '#' is skipped, so a misspelled setting doesn't become a branch. A branch
+with the same name as an earlier branch, or with a file another branch or the program already uses, is
+also skipped, since two branches writing back to the same file would overwrite each other's books.
+*/
+void loadBranchRegistry(void)
+{
+	std::string contents;
+	std::vector<std::string> fields;
+	std::unordered_set<std::string> names;
+	std::unordered_set<std::string> filenames = { s_checkedOutFileName, binarySnapshotFilename(s_checkedOutFileName), s_writeAheadLogFileName, s_branchRegistryFileName };
+	long long value;
+	int branch;
+
+	readSnapshotFile(s_branchRegistryFileName, contents);
+	csvReader record(contents);
+	while (record.nextRecord())
+	{
+		const std::string& name = record.field(0);
+		const std::string& filename = record.field(1);
+
+		if (record.metadataLine())
+		{
+			if ((name != "#shelvingBatchSize") && (name != "#shelvingBatchSeconds"))
+				std::cout << "**" << name << " in " << s_branchRegistryFileName << " isn't a setting, the line is skipped**" << std::endl;
+			else if (!parseInteger(filename, value) || (value < 1) || (value > INT32_MAX))
+				std::cout << "**" << name.substr(1) << " in " << s_branchRegistryFileName << " isn't a positive number, the default is used**" << std::endl;
+			else if (name == "#shelvingBatchSize")
+				s_shelvingBatchSize = (int)value;
+			else
+				s_shelvingBatchSeconds = (int)value;
+			continue;
+		}
+		if (record.getFieldCount() < 2)
+			continue;
+
+		if (names.count(name) != 0)
+			std::cout << "**The " << name << " branch is in " << s_branchRegistryFileName << " more than once, only the first is used**" << std::endl;
+		else if ((filenames.count(filename) != 0) || (filenames.count(binarySnapshotFilename(filename)) != 0))
+			std::cout << "**" << filename << " in " << s_branchRegistryFileName << " is already used by another branch or by the program, the " << name << " branch is skipped**" << std::endl;
+		else
+		{
+			names.insert(name);
+			filenames.insert(filename);
+			filenames.insert(binarySnapshotFilename(filename));
+			fields.push_back(name);
+			fields.push_back(filename);
+		}
+	}
+	if (fields.empty())
+		fields = { "Central", "CentralBranch.csv", "Point Grey", "PointGreyBranch.csv", "Mount Pleasant", "MountPleasantBranch.csv" };
+
+	for (size_t i = 0; i + 1 < fields.size(); i += 2)
+	{
+		branch = (int)s_branchObjects.size();
+		s_branchObjects.emplace_back(new Library(fields[i], fields[i + 1], branch));
+		s_branchWorkers.emplace_back(new branchWorker);
+		s_branchIds[fields[i]] = branch;
+	}
+}
+
+/*
+Initializes the objects of library, and the checked out books by reading
+all of the data from the .csv files to dynamic memory.
+
+The files don't depend on each other, so each branch is loaded on its own thread while
+the checked out books are loaded on this one. The availability index is shared by the
+branches, so the copies are counted in it after all of the branches have been loaded.
+*/
+void initializeLibraries(void)
+{
+	std::vector<std::thread> branchThreads(s_branchObjects.size());
+	std::vector<std::string> branchWarnings(s_branchObjects.size());
+	std::string checkedOutWarnings;
+
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+		branchThreads[i] = std::thread(loadBranchFile, i, std::ref(branchWarnings[i]));
+	loadCheckedOutFile(checkedOutWarnings);
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+		branchThreads[i].join();
+
+	std::cout << checkedOutWarnings;
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+	{
+		std::cout << branchWarnings[i];
+		s_branchObjects[i]->countCopies();
+	}
+}
+
+/*
+Adds all the books in the CheckedOut file to the static patronList object. The binary snapshot
+is loaded if there is one, otherwise the .csv file is read. The .csv file is also read in place of
+the binary snapshot if it was changed outside the program, see readChangedCsvFile.
+
+PARAM: string warnings, a line is appended for each file that doesn't match its checksum.
+*/
+void loadCheckedOutFile(std::string& warnings)
+{
+	std::string contents;
+	std::string filename;
+	std::vector<std::string> fields;
+	long long sequence = 0;
+	bool importedFlag = false;
+	bool keptFlag = false;
+
+	if (s_binarySnapshotFlag)
+	{
+		filename = binarySnapshotFilename(s_checkedOutFileName);
+		if (!readSnapshotFile(filename, contents))
+			warnings += "**" + filename + " doesn't match its checksum and may be damaged, reading " + s_checkedOutFileName + " instead**\n";
+		else if (readChangedCsvFile(s_checkedOutFileName, contents, 3, fields, sequence, keptFlag, warnings))
+			importedFlag = true;
+		else if (s_checkedOutObject.loadBinarySnapshot(contents, sequence))
+		{
+			s_checkedOutObject.setCheckpointSequence(sequence);
+			s_checkedOutObject.setCsvKeptFlag(keptFlag);
+			s_checkedOutObject.setDirtyFlag(false);
+			return;
+		}
+		else if (!contents.empty())
+			warnings += "**" + filename + " isn't a complete snapshot, reading " + s_checkedOutFileName + " instead**\n";
+	}
+
+	if (!importedFlag)
+	{
+		if (!readSnapshotFile(s_checkedOutFileName, contents))
+			warnings += "**" + s_checkedOutFileName + " doesn't match its checksum and may be damaged**\n";
+		parseCsvFile(contents, 3, fields, sequence);
+	}
+	s_checkedOutObject.setCheckpointSequence(sequence);
+
+	for (size_t i = 0; i + 2 < fields.size(); i += 3)
+		s_checkedOutObject.checkOut(fields[i], fields[i + 1], fields[i + 2]);
+
+	//Nothing has changed from what is in the files yet, unless the .csv file was read in place of
+	//the binary snapshot, which then has to be written back with the changes made outside the program.
+	s_checkedOutObject.setDirtyFlag(importedFlag);
+}
+
+/*
+Adds all the books in a branch's file to its static library object. The binary snapshot
+is loaded if there is one, otherwise the .csv file is read. The .csv file is also read in place of
+the binary snapshot if it was changed outside the program, see readChangedCsvFile.
+
+PARAM: int branch, the branch being loaded.
+PARAM: string warnings, a line is appended for each file that doesn't match its checksum.
+*/
+void loadBranchFile(int branch, std::string& warnings)
+{
+	Library* library = s_branchObjects[branch].get();
+	std::string contents;
+	std::string filename;
+	std::vector<std::string> fields;
+	long long sequence = 0;
+	bool importedFlag = false;
+	bool keptFlag = false;
+
+	if (s_binarySnapshotFlag)
+	{
+		filename = binarySnapshotFilename(library->getWritebackFilename());
+		if (!readSnapshotFile(filename, contents))
+			warnings += "**" + filename + " doesn't match its checksum and may be damaged, reading " + library->getWritebackFilename() + " instead**\n";
+		else if (readChangedCsvFile(library->getWritebackFilename(), contents, 2, fields, sequence, keptFlag, warnings))
+			importedFlag = true;
+		else if (library->loadBinarySnapshot(contents, sequence))
+		{
+			library->setCheckpointSequence(sequence);
+			library->setCsvKeptFlag(keptFlag);
+			library->setDirtyFlag(false);
+			return;
+		}
+		else if (!contents.empty())
+			warnings += "**" + filename + " isn't a complete snapshot, reading " + library->getWritebackFilename() + " instead**\n";
+	}
+
+	if (!importedFlag)
+	{
+		if (!readSnapshotFile(library->getWritebackFilename(), contents))
+			warnings += "**" + library->getWritebackFilename() + " doesn't match its checksum and may be damaged**\n";
+		parseCsvFile(contents, 2, fields, sequence);
+	}
+	library->setCheckpointSequence(sequence);
+	library->loadBooks(fields);
+
+	//Nothing has changed from what is in the files yet, unless the .csv file was read in place of
+	//the binary snapshot, which then has to be written back with the changes made outside the program.
+	library->setDirtyFlag(importedFlag);
+}
+
+/*
+Reads a .csv file in place of its binary snapshot if the .csv file was changed outside the program,
+for example to import books. The .csv file exported when the program exits is always newer than
+the binary snapshot, so the .csv file is only known to be changed from it not matching its checksum.
+
+A changed .csv file is only read if it isn't older than the binary snapshot, which is known from its
+checkpoint line, or from the times the files were modified if the checkpoint line was removed. An
+older .csv file, left from before the program stopped without exporting, isn't read, but it isn't
+overwritten either, so that any changes made to it by hand aren't lost.
+
+PARAM: string csvFilename, the .csv file.
+PARAM: string binaryContents, the contents of the binary snapshot that goes with the .csv file.
+PARAM: int fieldsPerRecord, the number of fields kept from each record.
+PARAM: vector<string> fields, set to the fields of the .csv file if it is read.
+PARAM: long long sequence, set to the checkpoint sequence number of the .csv file if it is read.
+PARAM: bool keptFlag, set to true if the .csv file was changed but is older than the binary snapshot.
+PARAM: string warnings, a line is appended if the .csv file was changed.
+RETURN: bool, true if the .csv file was read.
+*/
+bool readChangedCsvFile(const std::string& csvFilename, const std::string& binaryContents, int fieldsPerRecord, std::vector<std::string>& fields, long long& sequence, bool& keptFlag, std::string& warnings)
+{
+	std::string binaryFilename = binarySnapshotFilename(csvFilename);
+	std::string contents;
+	struct stat csvStatus, binaryStatus;
+	size_t position = 8;
+	long long binarySequence;
+	long long csvSequence = -1;
+	bool changedFlag;
+
+	//The sequence number follows the 8 byte magic at the start of every binary snapshot.
+	if (binaryContents.length() < position + sizeof(long long))
+		return false;
+	binarySequence = readBinaryValue<long long>(binaryContents, position);
+
+	readSnapshotFile(csvFilename, contents, &changedFlag);
+	if (!changedFlag)
+		return false;
+
+	parseCsvFile(contents, fieldsPerRecord, fields, csvSequence);
+	if ((csvSequence == -1) && (stat(csvFilename.c_str(), &csvStatus) == 0) && (stat(binaryFilename.c_str(), &binaryStatus) == 0)
+		&& (csvStatus.st_mtime >= binaryStatus.st_mtime))
+		csvSequence = binarySequence;
+
+	if (csvSequence < binarySequence)
+	{
+		fields.clear();
+		keptFlag = true;
+		warnings += "**" + csvFilename + " was changed outside the program but is older than " + binaryFilename + ", so it wasn't read and won't be overwritten**\n";
+		return false;
+	}
+
+	warnings += "**" + csvFilename + " was changed outside the program, so it was read instead of " + binaryFilename + "**\n";
+	sequence = csvSequence;
+	return true;
+}
+
+/*
+Splits the contents of a .csv file into fields. Large files are split into chunks at line ends and the
+chunks are parsed on separate threads, then the fields of each chunk are moved into place in order.
+A quoted field can have a newline in it, so files with quotes in them are always parsed in one piece.
+
+PARAM: string contents, the contents of the file.
+PARAM: int fieldsPerRecord, the number of fields kept from each record.
+PARAM: vector<string> fields, the fields of each record are appended, one record after the other.
+PARAM: long long checkpoint, set to the sequence number of the checkpoint line, if there is one.
+*/
+void parseCsvFile(const std::string& contents, int fieldsPerRecord, std::vector<std::string>& fields, long long& checkpoint)
+{
+	int chunkCount = (int)(contents.length() / s_parseChunkBytes) + 1;
+	int threadCount = (int)std::thread::hardware_concurrency();
+	const char* data = contents.data();
+	const char* chunkEnd;
+	size_t chunkStart = 0;
+	size_t split;
+	size_t totalFields = 0;
+
+	if (threadCount < 1)
+		threadCount = 1;
+	if (chunkCount > threadCount)
+		chunkCount = threadCount;
+	if ((chunkCount == 1) || (memchr(data, '"', contents.length()) != NULL))
+	{
+		parseCsvChunk(data, contents.length(), fieldsPerRecord, fields, checkpoint);
+		return;
+	}
+
+	std::vector<std::thread> threads(chunkCount);
+	std::vector<std::vector<std::string>> chunkFields(chunkCount);
+	std::vector<long long> chunkCheckpoints(chunkCount, -1);
+
+	for (int i = 0; i < chunkCount; i++)
+	{
+		//Each chunk ends at the first line end after its share of the file.
+		split = contents.length() * (i + 1) / chunkCount;
+		if (split < chunkStart)
+			split = chunkStart;
+		chunkEnd = (const char*)memchr(data + split, '\n', contents.length() - split);
+		chunkEnd = ((chunkEnd == NULL) || (i == chunkCount - 1)) ? data + contents.length() : chunkEnd + 1;
+
+		threads[i] = std::thread(parseCsvChunk, data + chunkStart, (chunkEnd - data) - chunkStart, fieldsPerRecord, std::ref(chunkFields[i]), std::ref(chunkCheckpoints[i]));
+		chunkStart = chunkEnd - data;
+	}
+	for (int i = 0; i < chunkCount; i++)
+	{
+		threads[i].join();
+		totalFields += chunkFields[i].size();
+		if (chunkCheckpoints[i] != -1)
+			checkpoint = chunkCheckpoints[i];
+	}
+
+	fields.reserve(fields.size() + totalFields);
+	for (int i = 0; i < chunkCount; i++)
+	{
+		for (size_t j = 0; j < chunkFields[i].size(); j++)
+			fields.push_back(std::move(chunkFields[i][j]));
+	}
+}
+
+/*
+Splits part of a .csv file into fields, used by parseCsvFile.
+
+PARAM: char* data, the start of the part, which starts at the start of a line.
+PARAM: size_t length, the number of bytes in the part, which ends at the end of a line.
+PARAM: int fieldsPerRecord, the number of fields kept from each record.
+PARAM: vector<string> fields, the fields of each record are appended, one record after the other.
+PARAM: long long checkpoint, set to the sequence number of the checkpoint line, if there is one.
+*/
+void parseCsvChunk(const char* data, size_t length, int fieldsPerRecord, std::vector<std::string>& fields, long long& checkpoint)
+{
+	csvReader reader(data, length);
+
+	while (reader.nextRecord())
+	{
+		if (reader.readCheckpoint(checkpoint) || reader.checksumLine())
+			continue;
+		for (int i = 0; i < fieldsPerRecord; i++)
+			fields.push_back(reader.field(i));
+	}
+}
+
+/*
+Replays the write ahead log over the objects read from the .csv files, then opens the log for appending.
+Each record is only applied to the objects whose .csv file doesn't include it yet, which is known
+from comparing the sequence number of the record to the checkpoint sequence number of the object.
+
+A partial record left at the end of the log by a crash during a flush isn't replayed, and is cut off
+the log before it is opened, so that the next record appended doesn't run on from it.
+
+RETURN: bool, true if any record was applied.
+*/
+bool replayWriteAheadLog(void)
+{
+	std::string contents;
+	long long sequence;
+	long long branch;
+	long long lastSequence = 0;
+	size_t tailStart = std::string::npos;
+	bool appliedFlag = false;
+
+	readSnapshotFile(s_writeAheadLogFileName, contents);
+	csvReader record(contents);
+	while (record.nextRecord())
+	{
+		const std::string& type = record.field(1);
+		const std::string& title = record.field(2);
+		const std::string& author = record.field(3);
+
+		if (!record.lineComplete())
+		{
+			tailStart = record.recordOffset();
+			break;
+		}
+		if (!writeAheadLog::validRecord(record, sequence))
+			continue;
+
+		if (type == "checkout")
+		{
+			parseInteger(record.field(5), branch);
+			if ((branch < (int)s_branchObjects.size()) && (sequence > s_branchObjects[branch]->getCheckpointSequence()))
+			{
+				s_branchObjects[branch]->deleteBook(title, author);
+				appliedFlag = true;
+			}
+			if (sequence > s_checkedOutObject.getCheckpointSequence())
+			{
+				s_checkedOutObject.checkOut(title, author, record.field(4));
+				appliedFlag = true;
+			}
+		}
+		else if (type == "checkin")
+		{
+			if (sequence > s_checkedOutObject.getCheckpointSequence())
+			{
+				s_checkedOutObject.checkIn(title, author);
+				appliedFlag = true;
+			}
+		}
+		else if (type == "return")
+		{
+			parseInteger(record.field(4), branch);
+			if ((branch < (int)s_branchObjects.size()) && (sequence > s_branchObjects[branch]->getCheckpointSequence()))
+			{
+				s_branchObjects[branch]->bookReturned(title, author);
+				appliedFlag = true;
+			}
+		}
+
+		if (sequence > lastSequence)
+			lastSequence = sequence;
+	}
+
+	//Sequence numbers carry on from the highest one in the log or in any .csv file.
+	if (s_checkedOutObject.getCheckpointSequence() > lastSequence)
+		lastSequence = s_checkedOutObject.getCheckpointSequence();
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+	{
+		if (s_branchObjects[i]->getCheckpointSequence() > lastSequence)
+			lastSequence = s_branchObjects[i]->getCheckpointSequence();
+	}
+
+	if (tailStart != std::string::npos)
+	{
+		contents.resize(tailStart);
+		if (writeSnapshotFile(s_writeAheadLogFileName, contents, false))
+			std::cout << "**A partial record at the end of the write ahead log was removed**" << std::endl;
+	}
+
+	if (!s_writeAheadLogObject.open(s_writeAheadLogFileName, lastSequence))
+		std::cout << "**Error opening write ahead log, changes will only be saved on writeback**" << std::endl;
+	return appliedFlag;
+}
+
+/*
+Used in a separate thread from the main function, every five minutes writes back the libraries and checked out
+books that have changed into their respective files. If the solution were scaled up to the size of an actual
+library and was being accessed by multiple computers, this writeback would be important.
+*/
+void writebackChanges(void)
+{
+	int i = 0;
+	while (true)
+	{
+		//----------------------------------------------------------------//
+		//checks to see if the program should end, and return if it should.
+		//----------------------------------------------------------------//
+		while (i < 5 * 60)
+		{
+			std::this_thread::sleep_until(std::chrono::system_clock::now() + std::chrono::seconds(1));
+			i++;
+			if (s_endProgram)
+				return;
+		}
+
+		if (persistChanges())
+			s_spreadsheetWritebackFlag = true;
+		i = 0;
+	}
+}
+
+/*
+Locks every library and the checked out books for reading, in the lock order. Every change is logged while the
+object it changes is locked for writing, so while these locks are held no change is partway through and the last
+write ahead log record is the last change included in every object.
+
+Only one thread takes snapshots at a time (the writeback thread, or main before and after it runs), so the dirty
+flags and checkpoint sequences can be updated while the objects are only locked for reading.
+*/
+void lockForSnapshot(void)
+{
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+		s_branchObjects[i]->getMutex().lock_shared();
+	s_checkedOutObject.getMutex().lock_shared();
+}
 
-		PARAM: string filename, the file to write back to.
-	*/
-	void fullListWriteback(std::string filename)
-	{
-		patronNode* traversal;
-		traversal = head;
+void unlockForSnapshot(void)
+{
+	s_checkedOutObject.getMutex().unlock_shared();
+	for (int i = (int)s_branchObjects.size() - 1; i >= 0; i--)
+		s_branchObjects[i]->getMutex().unlock_shared();
+}
 
-		//---------------------------------------------------//
-		//Opens and closes the file to delete before appending.
-		//---------------------------------------------------//
-		std::ofstream file;
-		file.open(filename);
-		file.close();
-		file.open(filename, std::ios::app);
+/*
+Writes back every library and the checked out books if they have changed since they were last written back.
+The changed objects are copied into buffers while they are all locked for reading, so the copies are consistent
+with each other, then the files are written after unlocking so that users aren't kept waiting on the file writes.
+If a file can't be written, its object is marked as changed again so that it is retried next time. Once every
+changed file has been written, the write ahead log records they include are removed from the log.
 
-		//--------------------//
-		//Linked list traversal.
-		//--------------------//
-		while (traversal->next != NULL)
+RETURN: bool, true if any file was written.
+*/
+bool persistChanges(void)
+{
+	std::string checkedOutSnapshot;
+	std::vector<std::string> branchSnapshots(s_branchObjects.size());
+	bool checkedOutChanged;
+	std::vector<bool> branchChanged(s_branchObjects.size());
+	bool written = false;
+	bool failed = false;
+	long long sequence;
+
+	lockForSnapshot();
+	sequence = s_writeAheadLogObject.getLastSequence();
+	checkedOutChanged = s_checkedOutObject.takeSnapshot(checkedOutSnapshot, sequence);
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+		branchChanged[i] = s_branchObjects[i]->takeSnapshot(branchSnapshots[i], sequence);
+	unlockForSnapshot();
+
+	if (checkedOutChanged)
+	{
+		if (writeSnapshotFile(s_checkedOutObject.getSnapshotFilename(), checkedOutSnapshot))
+			written = true;
+		else
 		{
-			traversal->patronWriteback(filename, file);
-			traversal = traversal->next;
+			failed = true;
+			s_checkedOutObject.getMutex().lock();
+			s_checkedOutObject.setDirtyFlag(true);
+			s_checkedOutObject.getMutex().unlock();
 		}
-		traversal->patronWriteback(filename, file);
-		file.close();
 	}
 
-	/*
-		function description:
-		deallocates the patron list.
-	*/
-	~patronList()
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
 	{
-		fullListWriteback(writebackFilename);
-
-		patronNode* traversal;
-		patronNode* next;
-
-		traversal = head;
-		next = traversal->next;
+		if (!branchChanged[i])
+			continue;
 
-		while (traversal->next != NULL)
+		if (writeSnapshotFile(s_branchObjects[i]->getSnapshotFilename(), branchSnapshots[i]))
+			written = true;
+		else
 		{
-			delete traversal;
-			traversal = next;
-			next = traversal->next;
+			failed = true;
+			s_branchObjects[i]->getMutex().lock();
+			s_branchObjects[i]->setDirtyFlag(true);
+			s_branchObjects[i]->getMutex().unlock();
 		}
-		delete traversal;
-
-		head = NULL;
 	}
-};
+
+	if (written && !failed)
+		s_writeAheadLogObject.truncateThrough(sequence);
+	return written;
+}
 
 /*
-	class description:
-	Library class inherits the booktree class, and also controls a linked list
-	of book nodes by using their rightLeafTitle bookNode* as 'next node'.
+Brings the .csv files up to date with the binary snapshots written back since they were last exported,
+so the .csv files can still be used to import and export. Used when the program exits. A .csv file
+that was changed outside the program but couldn't be read isn't overwritten, so the changes aren't lost.
 */
-class Library : public bookTree
+void exportCsvFiles(void)
 {
-private:
-	std::string writebackFilename;
-	bookNode* shelvingBacklogHead;
-	int linkedListLength;
-public:
-	Library(std::string WritebackFilename)
+	std::string checkedOutCsv;
+	std::vector<std::string> branchCsv(s_branchObjects.size());
+	bool checkedOutOutdated;
+	std::vector<bool> branchOutdated(s_branchObjects.size());
+	long long sequence;
+
+	lockForSnapshot();
+	sequence = s_writeAheadLogObject.getLastSequence();
+	checkedOutOutdated = s_checkedOutObject.getCsvOutdatedFlag() && !s_checkedOutObject.getCsvKeptFlag();
+	if (checkedOutOutdated)
+		s_checkedOutObject.takeCsvSnapshot(checkedOutCsv, sequence);
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
 	{
-		writebackFilename = WritebackFilename;
+		branchOutdated[i] = s_branchObjects[i]->getCsvOutdatedFlag() && !s_branchObjects[i]->getCsvKeptFlag();
+		if (branchOutdated[i])
+			s_branchObjects[i]->takeCsvSnapshot(branchCsv[i], sequence);
 	}
+	unlockForSnapshot();
 
-	/*
-		function description:
-		Returns a book. The book is added to a linked list of book nodes first, until
-		five books have accumulated, then they are shelved into the book tree.
-
-		PARAM: string title, title of the book being returned.
-		PARAM: string author, author of the book being returned.
-	*/
-	void bookReturned(std::string title, std::string author)
+	if (checkedOutOutdated && writeSnapshotFile(s_checkedOutObject.getWritebackFilename(), checkedOutCsv))
+		s_checkedOutObject.setCsvOutdatedFlag(false);
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
 	{
-		bookNode* newnode;
-		bookNode* traverse;
-		bookNode* nextnode;
-		newnode = new bookNode;
+		if (branchOutdated[i] && writeSnapshotFile(s_branchObjects[i]->getWritebackFilename(), branchCsv[i]))
+			s_branchObjects[i]->setCsvOutdatedFlag(false);
+	}
+}
 
-		newnode->assign(title, author);
+/*
+Returns the name of the binary snapshot that goes with a .csv file, which has the extension .bin instead.
+*/
+std::string binarySnapshotFilename(const std::string& csvFilename)
+{
+	return csvFilename.substr(0, csvFilename.rfind('.')) + ".bin";
+}
 
-		//If the linked list is empty, add the new node to the head.
-		if (shelvingBacklogHead == NULL)
-		{
-			shelvingBacklogHead = newnode;
-			linkedListLength = 1;
-			return;
-		}
+/*
+Replaces the contents of a .csv file. The contents are written to a temporary file with a checksum
+line at the end, synced to the disk, and then renamed over the .csv file, so that if the program stops
+part way through, the .csv file still has either all of the old contents or all of the new contents.
+
+PARAM: string filename, the file being written.
+PARAM: string contents, the new contents of the file.
+PARAM: bool checksumFlag, false to leave out the checksum line, for the write ahead log which is appended to.
+RETURN: bool, true if the file was written successfully.
+*/
+bool writeSnapshotFile(const std::string& filename, const std::string& contents, bool checksumFlag)
+{
+	std::string tempFilename = filename + ".tmp";
+	char footer[32];
+	int footerLength;
+	FILE* file;
+	bool written;
+
+	file = fopen(tempFilename.c_str(), "wb");
+	if (file == NULL)
+		return false;
+
+	//The contents are already in one buffer, so each file is written with a single call.
+	footerLength = snprintf(footer, sizeof(footer), "#checksum,%016llx\n", snapshotChecksum(contents.data(), contents.length()));
+	written = (fwrite(contents.data(), 1, contents.length(), file) == contents.length());
+	written = written && (!checksumFlag || (fwrite(footer, 1, footerLength, file) == (size_t)footerLength));
+	written = written && (fflush(file) == 0) && syncFile(file);
+	written = (fclose(file) == 0) && written;
+
+	if (written && replaceFile(tempFilename, filename))
+		return true;
 
-		traverse = shelvingBacklogHead;
-		//Using rightLeafTitle pointer like a next pointer so that the same class can
-		//be used in to form a tree and a linked list.
-		while (traverse->rightLeafTitle != NULL)
+	remove(tempFilename.c_str());
+	return false;
+}
+
+/*
+Reads the whole of a .csv file written by writeSnapshotFile, and checks it against the checksum line
+at the end, which is removed from the contents. Files without a checksum line are read as they are.
+The checksum line is removed even if it doesn't match, since a .csv file edited by hand still has the
+old checksum line, and it must not be read as a book.
+
+PARAM: string filename, the file being read.
+PARAM: string contents, set to the contents of the file, or left empty if the file doesn't exist.
+PARAM: bool changedFlag, if given, set to true if the file exists but doesn't end with a checksum line that
+	matches, which means it was written or changed outside the program.
+RETURN: bool, false if the file doesn't match its checksum.
+*/
+bool readSnapshotFile(const std::string& filename, std::string& contents, bool* changedFlag)
+{
+	std::ifstream file;
+	size_t footerStart;
+	unsigned long long checksum;
+	bool matchedFlag;
+
+	contents.clear();
+	if (changedFlag != NULL)
+		*changedFlag = false;
+	file.open(filename, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return true;
+	if (changedFlag != NULL)
+		*changedFlag = true;
+
+	contents.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read(&contents[0], contents.length());
+	contents.resize((size_t)file.gcount());
+	file.close();
+
+	//A file written by writeSnapshotFile always ends with a checksum line of a fixed length. Binary
+	//snapshots can have newlines anywhere, so the line is found by its length rather than by newlines.
+	if (contents.length() < s_checksumLineLength)
+		return true;
+
+	footerStart = contents.length() - s_checksumLineLength;
+	if ((contents.compare(footerStart, 10, "#checksum,") != 0) || (contents.back() != '\n'))
+		return true;
+	//A checksum line that isn't 16 hex digits is damaged, so the file can't be trusted either.
+	for (size_t i = footerStart + 10; i < contents.length() - 1; i++)
+	{
+		if (!isxdigit((unsigned char)contents[i]))
 		{
-			traverse = traverse->rightLeafTitle;
+			contents.resize(footerStart);
+			return false;
 		}
-		traverse->rightLeafTitle = newnode;
-		linkedListLength++;
+	}
 
-		//Books are shelved once five have been returned to the same library.
-		if (linkedListLength == 5)
-		{
-			//So that the user can be informed that books were shelved and at which library.
-			if (writebackFilename == "CentralBransh.csv")
-			{
-				s_CentralBranchBooksShelvedFlag = true;
-			}
-			else if (writebackFilename == "PointGreyBranch.csv")
-			{
-				s_PGBranchBooksShelvedFlag = true;
-			}
-			else
-			{
-				s_MPBranchBooksShelvedFlag = true;
-			}
+	checksum = strtoull(contents.c_str() + footerStart + 10, NULL, 16);
+	contents.resize(footerStart);
+	matchedFlag = (checksum == snapshotChecksum(contents.data(), footerStart));
+	if (changedFlag != NULL)
+		*changedFlag = !matchedFlag;
+	return matchedFlag;
+}
 
-			traverse = shelvingBacklogHead;
+/*
+Computes the checksum written at the end of each .csv file, using the 64 bit FNV-1a hash.
 
-			for (int i = 1; i <= 5; i++)
-			{
-				addBook(traverse->getTitle(), traverse->getAuthorName());
-				traverse = traverse->rightLeafTitle;
-			}
+PARAM: char* data, the start of the data.
+PARAM: size_t length, the number of bytes of data.
+RETURN: unsigned long long, the checksum.
+*/
+unsigned long long snapshotChecksum(const char* data, size_t length)
+{
+	unsigned long long hash = 14695981039346656037ULL;
 
-			//Once books have been added to the tree, deallocate list.
-			traverse = shelvingBacklogHead;
-			for (int i = 1; i <= 5; i++)
-			{
-				nextnode = traverse->rightLeafTitle;
-				delete traverse;
-				traverse = nextnode;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
 
-			}
+/*
+Renames a file over another file, replacing it in one step. On POSIX systems the rename is only saved to
+disk once the directory is synced, so the directory is synced before returning. Otherwise a crash could
+undo the rename of a snapshot after the write ahead log records it includes had been truncated.
 
-			//Head is set to null once books have been deallocated.
-			shelvingBacklogHead = NULL;
-		}
-	}
+PARAM: string from, the file being renamed.
+PARAM: string to, the file being replaced.
+RETURN: bool, true if the file was replaced and the rename was saved to disk.
+*/
+bool replaceFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	size_t slash = to.find_last_of('/');
+	std::string directory = (slash == std::string::npos) ? "." : to.substr(0, slash + 1);
+	int descriptor;
+	bool synced;
+
+	if (rename(from.c_str(), to.c_str()) != 0)
+		return false;
+
+	descriptor = open(directory.c_str(), O_RDONLY);
+	if (descriptor == -1)
+		return false;
+	synced = (fsync(descriptor) == 0);
+	close(descriptor);
+	return synced;
+#endif
+}
 
-	/*
-		function description:
-		If Library is being deconstructed, be sure to add the backlog of books
-		to the library even if there aren't five, and deallocate the list.
-		Also calls a writeback of the binary search tree which represents it using the
-		writebackFilename parameter.
-	*/
-	~Library()
+/*
+Appends a field to a line of a .csv file. If the field has a comma, quote, or newline in it, it is
+written in quotes with each quote doubled, so that csvReader reads it back the same. A field starting
+with '#' is also quoted, so that a book can't be mistaken for the checkpoint or checksum line.
+
+PARAM: string buffer, the line the field is appended to.
+PARAM: string field, the field being appended.
+*/
+void appendCsvField(std::string& buffer, const std::string& field)
+{
+	if ((field.find_first_of(",\"\r\n") == std::string::npos) && (field.empty() || (field[0] != '#')))
 	{
-		bookNode* traverse;
-		bookNode* nextnode;
-		traverse = shelvingBacklogHead;
-		while (traverse != NULL)
-		{
-			addBook(traverse->getTitle(), traverse->getAuthorName());
-			traverse = traverse->rightLeafTitle;
-		}
-		traverse = shelvingBacklogHead;
-		while (traverse != NULL)
-		{
-			nextnode = traverse->rightLeafTitle;
-			delete traverse;
-			traverse = nextnode;
-		}
+		buffer += field;
+		return;
+	}
 
-		writeback(writebackFilename);
-		shelvingBacklogHead = NULL;
+	buffer += '"';
+	for (size_t i = 0; i < field.length(); i++)
+	{
+		if (field[i] == '"')
+			buffer += '"';
+		buffer += field[i];
 	}
-};
+	buffer += '"';
+}
 
 /*
-Static variables, to be used by multiple threads.
+Appends the 32 bit offset and length of a string in the string pool of a binary snapshot to a record.
+If a map of pooled strings is given, a string that is already in the pool is reused rather than added again.
+
+PARAM: string records, the record the offset and length are appended to.
+PARAM: string pool, the string pool.
+PARAM: string str, the string.
+PARAM: unordered_map<string, uint32_t>* pooled, the offsets of the strings already pooled, or NULL to always add the string.
 */
-static std::string s_checkedOutFileName = "CheckedOut.csv";
-static std::string s_CentralBranchFileName = "CentralBranch.csv";
-static std::string s_PGBranchFileName = "PointGreyBranch.csv";
-static std::string s_MPBranchFileName = "MountPleasantBranch.csv";
+void appendBinaryString(std::string& records, std::string& pool, const std::string& str, std::unordered_map<std::string, uint32_t>* pooled)
+{
+	uint32_t offset = (uint32_t)pool.length();
 
-static patronList s_checkedOutObject(s_checkedOutFileName);
-static Library s_CentralBranchObject(s_CentralBranchFileName);
-static Library s_PGBranchObject(s_PGBranchFileName);
-static Library s_MPBranchObject(s_MPBranchFileName);
+	if (pooled != NULL)
+	{
+		std::pair<std::unordered_map<std::string, uint32_t>::iterator, bool> entry = pooled->insert(std::make_pair(str, offset));
+		offset = entry.first->second;
+		if (entry.second)
+			pool += str;
+	}
+	else
+		pool += str;
 
+	appendBinaryValue<uint32_t>(records, offset);
+	appendBinaryValue<uint32_t>(records, (uint32_t)str.length());
+}
 
-int main(void)
-{
-	//--------------------------------------------------------------------------------//
-	//Initialize, create writeback thread, then call the comand window control function.
-	//When control is passed back to main from the control window funciton, the static
-	//variable s_endProgram indicates to the writeback thread that it is time to stop.
-	//--------------------------------------------------------------------------------//
-	initializeLibraries();
+/*
+Reads the offset and length of a string from a record of a binary snapshot and moves the position past them.
 
-	std::thread t1(writebackAndReinitialize);
-	cmdWindowControl();
-	s_endProgram = true;
-	t1.join();
+PARAM: string contents, the contents of the snapshot.
+PARAM: size_t position, the position of the offset in the record.
+PARAM: size_t poolStart, the position of the string pool.
+PARAM: string* str, set to the string, or NULL to only check it.
+RETURN: bool, false if the string isn't inside the string pool.
+*/
+bool readBinaryString(const std::string& contents, size_t& position, size_t poolStart, std::string* str)
+{
+	uint32_t offset = readBinaryValue<uint32_t>(contents, position);
+	uint32_t length = readBinaryValue<uint32_t>(contents, position);
+
+	if (poolStart + (size_t)offset + length > contents.length())
+		return false;
+	if (str != NULL)
+		str->assign(contents, poolStart + offset, length);
+	return true;
 }
 
 /*
-Function that returns 1 if parameter a comes before b in alphabetical order,
-used to traverse binary search trees.
+Makes sure everything written to a file has reached the disk, not just the operating system.
+
+PARAM: FILE* file, the file to sync, which should already be flushed.
+RETURN: bool, true if the sync succeeded.
 */
-bool alphabetical(std::string a, std::string b)
+bool syncFile(FILE* file)
 {
-	return a < b;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
 }
 
 /*
-Initializes the objects of library, and the checked out books by reading
-all of the data from the .csv files to dynamic memory.
+Reads a whole string as a decimal integer. Unlike std::stoll it doesn't throw, so a damaged number in a file
+can be skipped rather than stopping the program.
+
+PARAM: string text, the string being read.
+PARAM: long long value, set to the integer.
+RETURN: bool, false if the string isn't an integer or is out of range.
 */
-void initializeLibraries(void)
+bool parseInteger(const std::string& text, long long& value)
 {
-	std::string line, word, title, author, patronName;
+	char* numberEnd;
 
-	std::ifstream checkedOutStream, CentralBranchStream, PGBranchStream, MPBranchStream;
+	if (text.empty() || !(isdigit((unsigned char)text[0]) || (text[0] == '-')))
+		return false;
 
-	checkedOutStream.open(s_checkedOutFileName);
-	CentralBranchStream.open(s_CentralBranchFileName);
-	PGBranchStream.open(s_PGBranchFileName);
-	MPBranchStream.open(s_MPBranchFileName);
+	errno = 0;
+	value = strtoll(text.c_str(), &numberEnd, 10);
+	return (errno == 0) && (numberEnd == text.c_str() + text.length());
+}
 
-	//--------------------------------------------------------------------------//
-	//Adding all the books in the CheckedOut file to the static patronList object.
-	//--------------------------------------------------------------------------//
-	while (getline(checkedOutStream, line))
-	{
-		std::stringstream ss(line);
-		getline(ss, word, ',');
-		title = word;
-		getline(ss, word, ',');
-		author = word;
-		getline(ss, word, ',');
-		patronName = word;
-		s_checkedOutObject.checkOut(title, author, patronName);
-	}
+/*
+Prints the books at every branch whose title or author starts with a prefix, in alphabetical order. Each branch
+finds its first s_searchResultLimit books, then the first s_searchResultLimit of those are printed once each,
+with the number of copies at each branch that has the book. None of the branches are locked.
 
-	//--------------------------------------------------------------------//
-	//Adding all the books in CentralBranch file to a static library object.
-	//--------------------------------------------------------------------//
-	while (getline(CentralBranchStream, line))
-	{
-		std::stringstream ss(line);
-		getline(ss, word, ',');
-		title = word;
-		getline(ss, word, ',');
-		author = word;
-		s_CentralBranchObject.addBook(title, author);
-	}
+PARAM: string prefix, the start of the title or author being searched for.
+PARAM: string select, whether to search the titles or the authors (must be 'title' or 'author').
+*/
+void printBranchMatches(const std::string& prefix, const std::string& select)
+{
+	std::map<std::pair<std::string, std::string>, std::string> books;
+	std::map<std::pair<std::string, std::string>, std::string>::iterator book;
+	std::vector<prefixMatch> matches;
+	treeSelect tree = (select == "author") ? AUTHOR_TREE : TITLE_TREE;
+	int printed = 0;
 
-	//---------------------------------------------------------------------//
-	//Adding all the books in PointGreyBranch file to a static library object.
-	//---------------------------------------------------------------------//
-	while (getline(PGBranchStream, line))
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
 	{
-		std::stringstream ss(line);
-		getline(ss, word, ',');
-		title = word;
-		getline(ss, word, ',');
-		author = word;
-		s_PGBranchObject.addBook(title, author);
+		matches.clear();
+		s_branchObjects[i]->searchPrefix(prefix, tree, s_searchResultLimit, matches);
+		for (int j = 0; j < (int)matches.size(); j++)
+		{
+			std::string& branches = (tree == TITLE_TREE) ? books[std::make_pair(matches[j].title, matches[j].author)]
+				: books[std::make_pair(matches[j].author, matches[j].title)];
+			if (!branches.empty())
+				branches += ", ";
+			branches += s_branchObjects[i]->getName() + ": " + std::to_string(matches[j].copies);
+		}
 	}
 
-	//--------------------------------------------------------------------------//
-	//Adding all the books in MountPleasantBranch file to a static library object.
-	//--------------------------------------------------------------------------//
-	while (getline(MPBranchStream, line))
+	if (books.empty())
+		std::cout << "          No books were found starting with '" << prefix << "'." << std::endl;
+	for (book = books.begin(); (book != books.end()) && (printed < s_searchResultLimit); book++, printed++)
 	{
-		std::stringstream ss(line);
-		getline(ss, word, ',');
-		title = word;
-		getline(ss, word, ',');
-		author = word;
-		s_MPBranchObject.addBook(title, author);
+		if (tree == TITLE_TREE)
+			std::cout << "          " << book->first.first << " by " << book->first.second << " (" << book->second << ")" << std::endl;
+		else
+			std::cout << "          " << book->first.second << " by " << book->first.first << " (" << book->second << ")" << std::endl;
 	}
-
-	checkedOutStream.close();
-	CentralBranchStream.close();
-	PGBranchStream.close();
-	MPBranchStream.close();
 }
 
 /*
-Used in a separate thread from the main function, writes back the dynamic instances of every book back into
-their respective files. The objects are then reinitialized. This action cleans up the deleted books by not
-writing back books with true delete flags. If the solution were scaled up to the size of an actual library
-and was being accessed by multiple computers, this writeback would be important.
+Checks out a book for a patron. The branch with a copy on the shelf is found in the availability index and the
+checkout is posted to that branch's worker, which logs it once the book is off the shelf and in the patron's list.
+If another checkout took the last copy at that branch first, the index is searched again for another branch.
+
+PARAM: long long sequence, set to the sequence number of the write ahead log record of the checkout.
+RETURN: int, the branchId of the branch the book was checked out from, or -1 if no branch has a copy.
 */
-void writebackAndReinitialize(void)
+int checkOutBook(const std::string& title, const std::string& author, const std::string& patron, long long& sequence)
 {
-	int i = 0;
-	while (true)
+	int branch;
+
+	sequence = 0;
+	branch = s_availabilityObject.findBranch(title, author);
+	while (branch != -1)
 	{
-		//----------------------------------------------------------------//
-		//checks to see if the program should end, and return if it should.
-		//----------------------------------------------------------------//
-		while (i < 5 * 60)
+		sequence = s_branchWorkers[branch]->post([&title, &author, &patron, branch](Library& library) -> long long
 		{
-			std::this_thread::sleep_until(std::chrono::system_clock::now() + std::chrono::seconds(1));
-			i++;
-			if (s_endProgram)
-				return;
-		}
-
-		//--------------------------------------------------------------------------//
-		//Need to lock so that the the program doesn't try to access books while they
-		//are being written back.
-		//--------------------------------------------------------------------------//
-		s_mu.lock();
-		//-----------------------------------//
-		//Writeback, reinitialize, then unlock.
-		//-----------------------------------//
-		s_checkedOutObject.~patronList();
-		s_CentralBranchObject.~Library();
-		s_PGBranchObject.~Library();
-		s_MPBranchObject.~Library();
-		initializeLibraries();
-		s_mu.unlock();
-		s_spreadsheetWritebackFlag = true;
-		i = 0;
+			std::string record;
+			long long recordSequence;
+
+			if (!library.deleteBook(title, author))
+				return 0;
+
+			s_checkedOutObject.getMutex().lock();
+			s_checkedOutObject.checkOut(title, author, patron);
+			record = "checkout,";
+			appendCsvField(record, title);
+			record += ',';
+			appendCsvField(record, author);
+			record += ',';
+			appendCsvField(record, patron);
+			record += ',' + std::to_string(branch);
+			recordSequence = s_writeAheadLogObject.append(record);
+			s_checkedOutObject.getMutex().unlock();
+			return recordSequence;
+		}).get();
+
+		if (sequence != 0)
+			return branch;
+		branch = s_availabilityObject.findBranch(title, author);
 	}
+	return -1;
+}
+
+/*
+Returns a book to a branch by posting it to the branch's worker, which adds it to the backlog of returned
+books and logs it. The worker shelves the backlog later, once a batch is ready.
+
+RETURN: long long, the sequence number of the write ahead log record of the return.
+*/
+long long returnBook(const std::string& title, const std::string& author, int branch)
+{
+	return s_branchWorkers[branch]->post([&title, &author, branch](Library& library) -> long long
+	{
+		std::string record;
+
+		library.bookReturned(title, author);
+		record = "return,";
+		appendCsvField(record, title);
+		record += ',';
+		appendCsvField(record, author);
+		record += ',' + std::to_string(branch);
+		return s_writeAheadLogObject.append(record);
+	}).get();
 }
 
 /*
@@ -893,8 +4551,29 @@ Flow of case statements and getlines that control the system based on inputs fro
 */
 void cmdWindowControl(void)
 {
-	std::string select, entered, title, author, patron;
+	std::string select, entered, title, author, patron, startKey;
 	char selectChar;
+	int page, pageSize;
+	int branch;
+	bool temp;
+	long long sequence;
+	std::string record;
+	std::string loanListing;
+	std::vector<std::string> patrons;
+	std::vector<int> cartBranches;
+	std::vector<prefixMatch> matches;
+	std::string branchPrompt = "enter ";
+
+	//The branches the user can return a book to, such as "enter 'A', 'B', or 'C' to select the library:"
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+	{
+		if (i > 0)
+			branchPrompt += (s_branchObjects.size() > 2) ? ", " : " ";
+		if ((i > 0) && (i == (int)s_branchObjects.size() - 1))
+			branchPrompt += "or ";
+		branchPrompt += "'" + s_branchObjects[i]->getName() + "'";
+	}
+	branchPrompt += " to select the library:";
 
 	//---------------------------------------------------------------------//
 	//When starting, or returning to start, check if any flags are up.
@@ -912,38 +4591,30 @@ start:
 		std::cout << "\n\n\n";
 		s_spreadsheetWritebackFlag = false;
 	}
-	if (s_CentralBranchBooksShelvedFlag)
-	{
-		std::cout << "\n\n\n";
-		std::cout << "          ***Returned books have been shelved at the central branch***" << std::endl;
-		std::cout << "\n\n\n";
-		s_CentralBranchBooksShelvedFlag = false;
-	}
-	if (s_PGBranchBooksShelvedFlag)
-	{
-		std::cout << "\n\n\n";
-		std::cout << "          ***Returned books have been shelved at the Point Grey branch***" << std::endl;
-		std::cout << "\n\n\n";
-		s_PGBranchBooksShelvedFlag = false;
-	}
-	if (s_MPBranchBooksShelvedFlag)
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
 	{
-		std::cout << "\n\n\n";
-		std::cout << "          ***Returned books have been shelved at the Mount Pleasant branch***" << std::endl;
-		std::cout << "\n\n\n";
-		s_MPBranchBooksShelvedFlag = false;
+		if (s_branchObjects[i]->takeShelvedFlag())
+		{
+			std::cout << "\n\n\n";
+			std::cout << "          ***Returned books have been shelved at the " << s_branchObjects[i]->getName() << " branch***" << std::endl;
+			std::cout << "\n\n\n";
+		}
 	}
 	std::cout << "          ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << std::endl;
 	std::cout << "          Check out book:                                            (enter 1)" << std::endl;
 	std::cout << "          view catalogue:                                            (enter 2)" << std::endl;
 	std::cout << "          Return book:                                               (enter 3)" << std::endl;
 	std::cout << "          Quit the application:                                      (enter 4)" << std::endl;
+	std::cout << "          View patron memory usage:                                  (enter 5)" << std::endl;
+	std::cout << "          View branch statistics:                                    (enter 6)" << std::endl;
+	std::cout << "          Search titles and authors:                                 (enter 7)" << std::endl;
 	std::cout << "          ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << std::endl;
 
 	//-----------------------------------------------------------------------------------------------//
 	//start_input:
 	//recieves input from the user then sends the to either check out a book, view the catalogue,
-	//or return a book.
+	//return a book, view the memory used by patrons, view the statistics of each branch,
+	//or search the titles and authors.
 	//-----------------------------------------------------------------------------------------------//
 start_input:
 	getline(std::cin, select, '\n');
@@ -964,6 +4635,12 @@ start_input:
 		goto return_book;
 	case '4':
 		return;
+	case '5':
+		goto memory_usage;
+	case '6':
+		goto branch_stats;
+	case '7':
+		goto search_books;
 	default:
 		std::cout << "          invalid entry, try again:" << std::endl;
 		goto start_input;
@@ -974,11 +4651,13 @@ start_input:
 	//----------------------------------------------------------------------//
 	//check_out:
 	//The user inputs the title, author, and the patron checking the book out.
-	//The program tries each library to see if that book is available,
-	//and if it is the book is checked out by the patron specified.
+	//The program looks up which library has the book available in the
+	//availability index, and if one does the book is checked out by the
+	//patron specified. If none does, the patrons who have it are listed,
+	//or if nobody has it, the books with a title starting with the title
+	//entered are listed in case it was mistyped.
 	//
-	//Need to ensure that s_mu.lock() and unlock() are used when accessing
-	//data in objects that could be written back and reinitialized.
+	//The checkout is made by the worker of the branch that has the book.
 	//----------------------------------------------------------------------//
 check_out:
 	std::cout << "          Enter the title, author, then the patron checking the book out." << std::endl;
@@ -993,37 +4672,56 @@ check_out:
 	patron = entered;
 	std::cout << std::endl;
 
-	s_mu.lock();
-	if (s_CentralBranchObject.deleteBook(title, author))
-	{
-		s_checkedOutObject.checkOut(title, author, patron);
-		std::cout << title << " by " << author << " checked out from the Central branch by " << patron << "." << std::endl;
-	}
-	else if (s_PGBranchObject.deleteBook(title, author))
+	branch = checkOutBook(title, author, patron, sequence);
+	if (branch == -1)
 	{
-		s_checkedOutObject.checkOut(title, author, patron);
-		std::cout << title << " by " << author << " checked out from the Point Grey branch by " << patron << "." << std::endl;
+		//If the book is checked out, let the user know who has it.
+		s_checkedOutObject.getMutex().lock_shared();
+		patrons = s_checkedOutObject.whoHasBook(title, author);
+		s_checkedOutObject.getMutex().unlock_shared();
+
+		//A copy that has been returned but not shelved yet will be available soon.
+		cartBranches.clear();
+		for (int i = 0; i < (int)s_branchObjects.size(); i++)
+		{
+			s_branchObjects[i]->getMutex().lock_shared();
+			if (s_branchObjects[i]->copiesOnCart(title, author) > 0)
+				cartBranches.push_back(i);
+			s_branchObjects[i]->getMutex().unlock_shared();
+		}
 	}
-	else if (s_MPBranchObject.deleteBook(title, author))
+
+	if (sequence != 0)
 	{
-		s_checkedOutObject.checkOut(title, author, patron);
-		std::cout << title << " by " << author << " checked out from the Mount Pleasant branch by " << patron << "." << std::endl;
+		if (!s_writeAheadLogObject.waitForCommit(sequence))
+			std::cout << "**Error writing to the write ahead log, this checkout will only be saved on writeback**" << std::endl;
+		std::cout << title << " by " << author << " checked out from the " << s_branchObjects[branch]->getName() << " branch by " << patron << "." << std::endl;
 	}
 	else
 	{
-		std::cout << "          The book entered is not available at any of our libraries";
+		std::cout << "          The book entered is not available at any of our libraries" << std::endl;
+		for (int i = 0; i < (int)patrons.size(); i++)
+			std::cout << "          A copy is checked out by " << patrons[i] << "." << std::endl;
+		for (int i = 0; i < (int)cartBranches.size(); i++)
+			std::cout << "          A copy has been returned to the " << s_branchObjects[cartBranches[i]]->getName() << " branch and is waiting to be shelved." << std::endl;
+		if (patrons.empty() && cartBranches.empty() && !title.empty())
+		{
+			std::cout << "          Books with a title starting with '" << title << "':" << std::endl;
+			printBranchMatches(title, "title");
+		}
 	}
-	s_mu.unlock();
 	goto start; //Return to start.
 
 
 	//------------------------------------------------------------------//
 	//view_catalogue:
 	//Program prints the contents of every library in alphabetical order
-	//according to title or author depending on what the user chooses.
+	//according to title or author depending on what the user chooses,
+	//starting from the title or author the user enters, either all at
+	//once or one page at a time.
 	//
-	//Need to ensure that s_mu.lock() and unlock() are used when accessing
-	//data in objects that could be written back and reinitialized.
+	//The branches print the last published version of their catalogues,
+	//so browsing doesn't lock them.
 	//------------------------------------------------------------------//
 view_catalogue:
 	std::cout << "          Enter whether the catalogue should be in alphabetical order of 'title' or 'author':" << std::endl;
@@ -1034,17 +4732,26 @@ view_catalogue_entry:
 		std::cout << "          Invalid entry, please enter 'title' or 'author':" << std::endl;
 		goto view_catalogue_entry;
 	}
-	s_mu.lock();
-	std::cout << "\n\n";
-	std::cout << "The books at the Central branch are:" << std::endl;
-	s_CentralBranchObject.printList(entered);
-	std::cout << "\n\n";
-	std::cout << "The books at the Point Grey branch are:" << std::endl;
-	s_PGBranchObject.printList(entered);
-	std::cout << "\n\n";
-	std::cout << "The books at the Mount Pleasant branch are:" << std::endl;
-	s_PGBranchObject.printList(entered);
-	s_mu.unlock();
+	select = entered;
+	std::cout << "          Enter the " << select << " to start the catalogue from, or leave blank to view the whole catalogue:" << std::endl;
+	getline(std::cin, startKey, '\n');
+	std::cout << "          Enter the page to view and the number of books on each page (such as '2 20'), or leave blank to view every book:" << std::endl;
+view_catalogue_page:
+	getline(std::cin, entered, '\n');
+	page = 1;
+	pageSize = 0;
+	if (!entered.empty() && ((sscanf(entered.c_str(), "%d %d", &page, &pageSize) != 2) || (page < 1) || (pageSize < 1)))
+	{
+		std::cout << "          Invalid entry, please enter the page and the number of books on each page, or leave blank:" << std::endl;
+		goto view_catalogue_page;
+	}
+
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+	{
+		std::cout << "\n\n";
+		std::cout << "The books at the " << s_branchObjects[i]->getName() << " branch are:" << std::endl;
+		s_branchObjects[i]->printList(select, startKey, page, pageSize);
+	}
 	goto start; //Return to start.
 
 
@@ -1056,14 +4763,22 @@ view_catalogue_entry:
 	//if the book entered is valid, the user also chooses which 
 	//library the book is being returned to. The book is then
 	//removed from the patron list object, and added to the proper
-	//library object.
+	//library object. If the book entered isn't checked out, the
+	//checked out books with a title starting with the title entered
+	//are listed before trying again.
 	//
-	//Need to ensure that s_mu.lock() and unlock() are used when accessing
-	//data in objects that could be written back and reinitialized.
+	//Checking the book in only locks the checked out books, and the book
+	//is shelved by the worker of the branch it is returned to. The list
+	//of checked out books is copied under the lock and printed after it.
 	//------------------------------------------------------------------//
 return_book:
 	std::cout << "          The following patrons have the following books checked out." << std::endl;
-	s_checkedOutObject.printList("title");
+	loanListing.clear();
+	s_checkedOutObject.getMutex().lock_shared();
+	s_checkedOutObject.appendList(loanListing, "title");
+	s_checkedOutObject.getMutex().unlock_shared();
+	std::cout << loanListing;
+	std::cout.flush();
 	std::cout << "          Enter the title, author, and library being returned to." << std::endl;
 return_book_entry:
 	std::cout << "title: ";
@@ -1073,30 +4788,93 @@ return_book_entry:
 	getline(std::cin, entered, '\n');
 	author = entered;
 
-	s_mu.lock();
-	bool temp = !s_checkedOutObject.checkIn(title, author);
-	s_mu.unlock();
+	s_checkedOutObject.getMutex().lock();
+	temp = !s_checkedOutObject.checkIn(title, author);
+	if (!temp)
+	{
+		record = "checkin,";
+		appendCsvField(record, title);
+		record += ',';
+		appendCsvField(record, author);
+		sequence = s_writeAheadLogObject.append(record);
+	}
+	s_checkedOutObject.getMutex().unlock();
 
 	if (temp)
 	{
+		if (!title.empty())
+		{
+			s_checkedOutObject.getMutex().lock_shared();
+			matches = s_checkedOutObject.findPrefix(title, s_searchResultLimit);
+			s_checkedOutObject.getMutex().unlock_shared();
+			for (int i = 0; i < (int)matches.size(); i++)
+				std::cout << "          Did you mean " << matches[i].title << " by " << matches[i].author << "?" << std::endl;
+		}
 		std::cout << "          Invalid book entry, please try again:" << std::endl;
 		goto return_book_entry;
 	}
 
 book_entry_library:
-	std::cout << "enter 'Central', 'Point Grey', or 'Mount Pleasant' to select the library:";
+	std::cout << branchPrompt;
 	getline(std::cin, entered, '\n');
-	if ((entered != "Central") && (entered != "Point Grey") && (entered != "Mount Pleasant"))
+	if (s_branchIds.find(entered) == s_branchIds.end())
 		goto book_entry_library;
+	branch = s_branchIds[entered];
 
-	s_mu.lock();
-	if (entered == "Central")
-		s_CentralBranchObject.bookReturned(title, author);
-	else if (entered == "Point Grey")
-		s_PGBranchObject.bookReturned(title, author);
-	else
-		s_MPBranchObject.bookReturned(title, author);
-	s_mu.unlock();
+	sequence = returnBook(title, author, branch);
+
+	if (!s_writeAheadLogObject.waitForCommit(sequence))
+		std::cout << "**Error writing to the write ahead log, this return will only be saved on writeback**" << std::endl;
 	std::cout << title << " by " << author << " returned to " << entered << " branch." << std::endl;
 	goto start;//return to start.
+
+
+	//------------------------------------------------------------------//
+	//memory_usage:
+	//Prints how much memory the patrons and their checked out books use.
+	//------------------------------------------------------------------//
+memory_usage:
+	s_checkedOutObject.getMutex().lock_shared();
+	s_checkedOutObject.printMemoryUsage();
+	s_checkedOutObject.getMutex().unlock_shared();
+	goto start; //Return to start.
+
+
+	//------------------------------------------------------------------//
+	//branch_stats:
+	//Prints the number of books, checkouts, and returns at each branch,
+	//and how much memory each branch uses.
+	//------------------------------------------------------------------//
+branch_stats:
+	for (int i = 0; i < (int)s_branchObjects.size(); i++)
+	{
+		s_branchObjects[i]->getMutex().lock_shared();
+		s_branchObjects[i]->printStats();
+		s_branchObjects[i]->getMutex().unlock_shared();
+	}
+	goto start; //Return to start.
+
+
+	//------------------------------------------------------------------//
+	//search_books:
+	//The user enters the start of a title or author, and the first books
+	//that match are listed with the copies at each branch, so the exact
+	//title and author can be found before checking a book out.
+	//
+	//Like the catalogue, searching doesn't lock the branches.
+	//------------------------------------------------------------------//
+search_books:
+	std::cout << "          Enter whether to search by 'title' or 'author':" << std::endl;
+search_books_entry:
+	getline(std::cin, entered, '\n');
+	if ((entered != "title") && (entered != "author"))
+	{
+		std::cout << "          Invalid entry, please enter 'title' or 'author':" << std::endl;
+		goto search_books_entry;
+	}
+	select = entered;
+	std::cout << "          Enter the start of the " << select << ":" << std::endl;
+	getline(std::cin, entered, '\n');
+	printBranchMatches(entered, select);
+	goto start; //Return to start.
 }
\ No newline at end of file
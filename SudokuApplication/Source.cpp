@@ -6,6 +6,7 @@ date updated:	September 12th, 2021
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 
 void printPuzzle(int puzzle[9][9]);
 bool isSolved(int puzzle[9][9]);
@@ -18,7 +19,7 @@ bool solveSudoku(int puzzle[9][9], int row_num, int column_num);
 /*
 	class description:
 	Objects of sudokuNode class function as storage for information on a specific sudoku
-	puzzle, and as nodes in a linked list.
+	puzzle, and as elements of the contiguous node array owned by sudokuList.
 
 	important info:
 	 - The information that fills the properties of sudokuNode comes from text files, the file
@@ -28,17 +29,19 @@ bool solveSudoku(int puzzle[9][9], int row_num, int column_num);
 	 - Instead, the properties are declared to a default value.
 	 - The boolean property 'puzzleAssignedFlag' is used to restrain the program from
 	 doing actions on properties of sudokuNode if they are not assigned.
+	 - The puzzle name is not stored in the node. It lives in the name pool of sudokuList, and
+	 the node only keeps the offset and length of its name within that pool.
 */
 class sudokuNode
 {
 private:
-	std::string puzzlename = "";
 	bool puzzleAssignedFlag = false;
 	int puzzle_unsolved[9][9] = { -1 };
 	int puzzle_solved[9][9] = { -1 };
 
 public:
-	sudokuNode* next = NULL;
+	int nameOffset = 0;
+	int nameLength = 0;
 
 	/*
 		function description:
@@ -58,8 +61,6 @@ public:
 		//Only allow object to be assigned if it has not been assigned previously.
 		if (!puzzleAssignedFlag)
 		{
-			puzzlename = puzzleName;
-
 			//If file opens properly, assign the values from the text file to
 			//both puzzle_unsolved and puzzle_solved.
 			std::string filename = puzzleName + ".txt";
@@ -147,106 +148,114 @@ public:
 			std::cout << "**Error: Program attempted to access puzzle that has not been assigned**" << std::endl;
 	}
 
-	/*
-		function description
-		If the puzzle has been assigned, returns the puzzlename.
-
-		RETURN: string representing name of puzzle.
-	*/
-	std::string getPuzzleName(void)
+	bool getPuzzleAssignedFlag(void)
 	{
-		if (puzzleAssignedFlag)
-		{
-			return puzzlename;
-		}
-		else
-		{
-			std::cout << "**Error: Program attempted to access puzzle that has not been assigned**" << std::endl;
-			return "";
-		}
-
+		return puzzleAssignedFlag;
 	}
 };
 
 /*
 	class description:
 	The sudokuList class does all operations that allocate, traverse, access data from, and deallocate
-	from a linked list of sudokuNodes.
+	from the catalog of sudokuNodes.
 
 	The goal with the sudokuList class was to cover up as much as possible, so that any actions done
 	relating to the actual puzzles in the program are done through calls funcitons of sudokuList.
 
 	important info:
-	There is a text file FilenameList.txt that is hardcoded in this class which has the file names
-	of all the sudoku text files that need to be added to the linked list.
+	 - There is a text file FilenameList.txt that is hardcoded in this class which has the file names
+	of all the sudoku text files that need to be added to the catalog.
+	 - The nodes are stored contiguously in a vector instead of being allocated one at a time, so a
+	puzzle is identified by its index in the vector. Indices stay valid as puzzles are added because
+	puzzles are only ever appended.
+	 - The names of all puzzles are stored back to back in a single string (the name pool), so
+	traversing the names doesn't jump around the heap and the whole catalog is freed at once.
 */
 class sudokuList
 {
 private:
-	sudokuNode* head;
+	std::vector<sudokuNode> nodes;
+	std::string namePool;
 
 	/*
 		function description:
-		Finds whether a puzzle with a given name is in the linked list.
+		Allocates a node at the end of the node vector, copies the puzzle name into the name pool,
+		and assigns the puzzle from its text file.
 
-		PARAM: string puzzleName: the name of the puzzle being searched for.
-		RETURN: sudokuNode pointer, the address of the puzzle being searched for if found, or NULL if no puzzle was found with the provided name.
+		PARAM: string puzzleName: the name of the puzzle being added.
 	*/
-	sudokuNode* findPuzzle(std::string puzzleName)
+	void appendPuzzle(std::string puzzleName)
 	{
-		sudokuNode* traversal = head;
+		nodes.emplace_back();
+		sudokuNode& newNode = nodes.back();
+
+		newNode.nameOffset = namePool.length();
+		newNode.nameLength = puzzleName.length();
+		namePool += puzzleName;
+		newNode.assignPuzzle(puzzleName);
+	}
 
-		//Checks each node in the linked list to see if the puzzleName parameter matches the puzzleName of the node
-		//and returns a pointer to that node if it does. Returns the NULL pointer if a node with puzzleName was not found.
-		if (puzzleName == traversal->getPuzzleName())
+	/*
+		function description
+		If the puzzle has been assigned, returns the name of the puzzle from the name pool.
+
+		PARAM: sudokuNode node: the node whose name is being returned.
+		RETURN: string representing name of puzzle.
+	*/
+	std::string getPuzzleName(sudokuNode& node)
+	{
+		if (node.getPuzzleAssignedFlag())
 		{
-			return traversal;
+			return namePool.substr(node.nameOffset, node.nameLength);
 		}
 		else
 		{
-			do
+			std::cout << "**Error: Program attempted to access puzzle that has not been assigned**" << std::endl;
+			return "";
+		}
+	}
+
+	/*
+		function description:
+		Finds whether a puzzle with a given name is in the catalog.
+
+		PARAM: string puzzleName: the name of the puzzle being searched for.
+		RETURN: integer, the index of the puzzle being searched for if found, or -1 if no puzzle was found with the provided name.
+	*/
+	int findPuzzle(std::string puzzleName)
+	{
+		int length = puzzleName.length();
+
+		//Compares against the name pool in place, so no string is built for the nodes that don't match.
+		//Nodes that were never assigned have no name and are skipped.
+		for (int i = 0; i < (int)nodes.size(); i++)
+		{
+			if (nodes[i].getPuzzleAssignedFlag() && (nodes[i].nameLength == length) &&
+				(namePool.compare(nodes[i].nameOffset, length, puzzleName) == 0))
 			{
-				traversal = traversal->next;
-				if (puzzleName == traversal->getPuzzleName())
-				{
-					return traversal;
-				}
-			} while (traversal->next != NULL);
+				return i;
+			}
 		}
-		return NULL;
+		return -1;
 	}
 
 public:
 	/*
 		function description:
-		Creates the head node for the list, and fills in the linked list with all the
-		puzzles specified in the FilenameList.txt file.
+		Fills in the catalog with all the puzzles specified in the FilenameList.txt file.
 	*/
 	sudokuList(void)
 	{
 		std::string puzzleName;
 		std::ifstream sudokuListFile;
 
-		//Defines the head node pointer, allocates the head node,
-		//and assigns it the puzzle specified by the first line in FilenameList.txt.
-		sudokuNode* newNode;
-		sudokuNode* traversalNode;
-		head = new sudokuNode;
-
 		sudokuListFile.open("FilenameList.txt");
-		getline(sudokuListFile, puzzleName);
-
-		head->assignPuzzle(puzzleName);
-		traversalNode = head;
 
 		//Iterates through all lines in the FilenameList.txt file, 
 		//allocating and assigning nodes of sudokuNode.
 		while (getline(sudokuListFile, puzzleName))
 		{
-			newNode = new sudokuNode;
-			newNode->assignPuzzle(puzzleName);
-			traversalNode->next = newNode;
-			traversalNode = newNode;
+			appendPuzzle(puzzleName);
 		}
 	}
 
@@ -259,7 +268,6 @@ public:
 	{
 		std::string line, filename;
 		std::ofstream sudokuListFile, sudokuFile;
-		sudokuNode* traversal;
 		int length, j;
 		int puzzle[9][9], puzzleCheckSolved[9][9];
 		const char* digit;
@@ -269,7 +277,7 @@ public:
 		std::cout << "          Enter sudoku file name:" << std::endl;
 	get_sudoku_name:
 		getline(std::cin, filename, '\n');
-		if (findPuzzle(filename) != NULL)
+		if (findPuzzle(filename) != -1)
 		{
 			std::cout << "          System already has a sudoku with that name, please put in a different file name:" << std::endl;
 			goto get_sudoku_name;
@@ -336,16 +344,9 @@ public:
 				sudokuListFile.close();
 			}
 
-			//Allocates and assigns a new sudokuNode with the information given by the user,
-			//and traverses through the linked list to add it to the end.
-			traversal = head;
-			while (traversal->next != NULL)
-			{
-				traversal = traversal->next;
-			}
-			traversal->next = new sudokuNode;
-			traversal = traversal->next;
-			traversal->assignPuzzle(filename);
+			//Allocates and assigns a new sudokuNode with the information given by the user
+			//at the end of the catalog.
+			appendPuzzle(filename);
 
 			std::cout << "           " << filename << " has been successfully added!" << std::endl;
 		}
@@ -353,32 +354,27 @@ public:
 
 	/*
 		function description:
-		Displays the names of all puzzles in the linked list.
+		Displays the names of all puzzles in the catalog.
 	*/
 	void displayPuzzleNames(void)
 	{
-		sudokuNode* traversal = head;
-		std::string name;
-
-		while (traversal != NULL)
+		for (int i = 0; i < (int)nodes.size(); i++)
 		{
-			name = traversal->getPuzzleName();
-			std::cout << name << std::endl;
-			traversal = traversal->next;
+			std::cout << getPuzzleName(nodes[i]) << std::endl;
 		}
 	}
 
 	/*
 		function description:
-		Displays the unsolved representation of a puzzle in the linked list.
+		Displays the unsolved representation of a puzzle in the catalog.
 	*/
 	void displayUnsolved(std::string puzzleName)
 	{
-		sudokuNode* sudoku;
+		int sudoku;
 		sudoku = findPuzzle(puzzleName);
-		if (sudoku != NULL)
+		if (sudoku != -1)
 		{
-			sudoku->displayUnsolvedPuzzle();
+			nodes[sudoku].displayUnsolvedPuzzle();
 		}
 		else
 		{
@@ -389,15 +385,15 @@ public:
 
 	/*
 		function description:
-		Displays the solved representation of a puzzle in the linked list.
+		Displays the solved representation of a puzzle in the catalog.
 	*/
 	void displaySolved(std::string puzzleName)
 	{
-		sudokuNode* sudoku;
+		int sudoku;
 		sudoku = findPuzzle(puzzleName);
-		if (sudoku != NULL)
+		if (sudoku != -1)
 		{
-			sudoku->displaySolvedPuzzle();
+			nodes[sudoku].displaySolvedPuzzle();
 		}
 		else
 		{
@@ -412,7 +408,7 @@ public:
 	*/
 	void checkSudoku(std::string puzzleName)
 	{
-		sudokuNode* sudoku;
+		int sudoku;
 		int puzzle[9][9];
 		int length;
 		const char* digit;
@@ -421,7 +417,12 @@ public:
 
 
 		sudoku = findPuzzle(puzzleName);
-		sudoku->getSolvedPuzzle(puzzle);
+		if (sudoku == -1)
+		{
+			std::cout << std::endl << "**Sudoku with that name was not found**" << std::endl;
+			return;
+		}
+		nodes[sudoku].getSolvedPuzzle(puzzle);
 
 		std::cout << "          NOTE: all lines of sudoku puzzle must be entered as 9 integer values seperated by spaces, '0' represents an empty square." << std::endl;
 		std::cout << "          Enter sudoku puzzle:" << std::endl;
@@ -468,26 +469,8 @@ public:
 			std::cout << "          Unfortunately, that was the incorrect solution." << std::endl;
 	}
 
-	/*
-		function description:
-		Deallocate all the memory in the linked list.
-	*/
-	~sudokuList(void)
-	{
-		sudokuNode* traversal;
-		sudokuNode* next;
-
-		traversal = head;
-		next = traversal->next;
-
-		while (traversal->next != NULL)
-		{
-			delete traversal;
-			traversal = next;
-			next = traversal->next;
-		}
-		delete traversal;
-	}
+	//The node vector and the name pool are each freed in one piece when the list goes out of scope,
+	//so no destructor is needed.
 };
 
 int main(void)